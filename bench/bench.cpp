@@ -0,0 +1,463 @@
+#ifdef CPPGLOB_BUILDING
+#  undef CPPGLOB_BUILDING
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <cppglob/fnmatch.hpp>
+#include <cppglob/glob.hpp>
+#include <cppglob/iglob.hpp>
+#include <cppglob/static_pattern.hpp>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#  define CPPGLOB_BENCH_COUNT_CALLS 1
+#  include <cstdarg>
+#  include <dlfcn.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using bench_clock = std::chrono::steady_clock;
+
+static std::atomic<unsigned long> num_allocs(0);
+static std::atomic<unsigned long> num_calls(0);
+
+// count every allocation of the program, including those of the library
+
+void* operator new(std::size_t size) {
+  ++num_allocs;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// used by std::pmr::new_delete_resource()
+void* operator new(std::size_t size, std::align_val_t align) {
+  ++num_allocs;
+  const std::size_t alignment = static_cast<std::size_t>(align);
+  const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  if (void* p = std::aligned_alloc(alignment, rounded == 0 ? alignment
+                                                           : rounded)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+#ifdef CPPGLOB_BENCH_COUNT_CALLS
+// Count the file system calls made through the C library by interposing the
+// functions used by the library and by std::filesystem. The definitions of
+// the executable take precedence over those of libc for the shared library.
+template <typename F>
+static F next_function(const char* name) {
+  return reinterpret_cast<F>(::dlsym(RTLD_NEXT, name));
+}
+
+extern "C" {
+int open(const char* path, int flags, ...) {
+  static auto fn = next_function<int (*)(const char*, int, ...)>("open");
+  va_list args;
+  va_start(args, flags);
+  const mode_t mode = va_arg(args, mode_t);
+  va_end(args);
+  ++num_calls;
+  return fn(path, flags, mode);
+}
+
+int openat(int dirfd, const char* path, int flags, ...) {
+  static auto fn =
+      next_function<int (*)(int, const char*, int, ...)>("openat");
+  va_list args;
+  va_start(args, flags);
+  const mode_t mode = va_arg(args, mode_t);
+  va_end(args);
+  ++num_calls;
+  return fn(dirfd, path, flags, mode);
+}
+
+int close(int fd) {
+  static auto fn = next_function<int (*)(int)>("close");
+  ++num_calls;
+  return fn(fd);
+}
+
+off_t lseek(int fd, off_t offset, int whence) {
+  static auto fn = next_function<off_t (*)(int, off_t, int)>("lseek");
+  ++num_calls;
+  return fn(fd, offset, whence);
+}
+
+#  if __GLIBC_PREREQ(2, 33)
+int stat(const char* path, struct stat* buf) {
+  static auto fn = next_function<int (*)(const char*, struct stat*)>("stat");
+  ++num_calls;
+  return fn(path, buf);
+}
+
+int lstat(const char* path, struct stat* buf) {
+  static auto fn = next_function<int (*)(const char*, struct stat*)>("lstat");
+  ++num_calls;
+  return fn(path, buf);
+}
+
+int fstat(int fd, struct stat* buf) {
+  static auto fn = next_function<int (*)(int, struct stat*)>("fstat");
+  ++num_calls;
+  return fn(fd, buf);
+}
+
+int fstatat(int dirfd, const char* path, struct stat* buf, int flags) {
+  static auto fn =
+      next_function<int (*)(int, const char*, struct stat*, int)>("fstatat");
+  ++num_calls;
+  return fn(dirfd, path, buf, flags);
+}
+#  endif
+
+long syscall(long number, ...) {
+  static auto fn = next_function<long (*)(long, ...)>("syscall");
+  va_list args;
+  va_start(args, number);
+  long a[6];
+  for (long& arg : a) {
+    arg = va_arg(args, long);
+  }
+  va_end(args);
+  ++num_calls;
+  return fn(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+}
+#endif
+
+struct sample {
+  double ns;
+  std::size_t results;
+  unsigned long calls;
+  unsigned long allocs;
+};
+
+// best of several runs
+template <typename F>
+static sample measure(F&& fn, int runs = 5) {
+  sample best{0.0, 0L, 0L, 0L};
+
+  for (int i = 0; i < runs; ++i) {
+    const unsigned long calls = num_calls, allocs = num_allocs;
+    const auto start = bench_clock::now();
+    const std::size_t results = fn();
+    const auto stop = bench_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+
+    if (i == 0 || ns < best.ns) {
+      best = {ns, results, num_calls - calls, num_allocs - allocs};
+    }
+  }
+
+  return best;
+}
+
+static void report(const char* tree, const char* function,
+                   const std::string& pattern, std::size_t entries,
+                   const sample& s) {
+#ifdef CPPGLOB_BENCH_COUNT_CALLS
+  const std::string calls = std::to_string(s.calls);
+#else
+  const std::string calls = "-";
+#endif
+  std::printf("%-8s %-10s %-22s %9zu %10.1f %10s %10lu\n", tree, function,
+              pattern.c_str(), s.results, s.ns / entries, calls.c_str(),
+              s.allocs);
+}
+
+static void create_file(const fs::path& path) {
+  if (FILE* fp = std::fopen(path.c_str(), "w")) {
+    std::fclose(fp);
+  }
+}
+
+static std::string number(std::size_t i, std::size_t width) {
+  std::string str = std::to_string(i);
+  return std::string(width > str.size() ? width - str.size() : 0, '0') + str;
+}
+
+static const char* const exts[] = {".txt", ".cpp", ".h", ".o"};
+
+// one directory with many files
+static void make_wide(const fs::path& dir, std::size_t scale) {
+  fs::create_directories(dir);
+  for (std::size_t i = 0; i < 20000 * scale; ++i) {
+    create_file(dir / ("f" + number(i, 6) + exts[i % 4]));
+  }
+}
+
+// a single long chain of directories
+static void make_deep(const fs::path& dir, std::size_t scale) {
+  fs::path path = dir;
+  for (std::size_t depth = 0; depth < 64 * scale; ++depth) {
+    path /= "d" + std::to_string(depth % 10);
+    fs::create_directories(path);
+    for (std::size_t i = 0; i < 8; ++i) {
+      create_file(path / ("f" + std::to_string(i) + exts[i % 4]));
+    }
+  }
+}
+
+// a balanced tree of small directories
+static void make_small(const fs::path& dir, std::size_t scale) {
+  const std::size_t fanout = 12 * scale;
+  for (std::size_t a = 0; a < fanout; ++a) {
+    for (std::size_t b = 0; b < fanout; ++b) {
+      for (std::size_t c = 0; c < 12; ++c) {
+        const fs::path path = dir / ("d" + std::to_string(a)) /
+                              ("d" + std::to_string(b)) /
+                              ("d" + std::to_string(c));
+        fs::create_directories(path);
+        for (std::size_t i = 0; i < 3; ++i) {
+          create_file(path / ("f" + std::to_string(i) + exts[i % 4]));
+        }
+      }
+    }
+  }
+}
+
+// half of the entries start with a dot
+static void make_hidden(const fs::path& dir, std::size_t scale) {
+  for (std::size_t d = 0; d < 50 * scale; ++d) {
+    const fs::path path =
+        dir / ((d % 2 ? ".d" : "d") + std::to_string(d));
+    fs::create_directories(path);
+    for (std::size_t i = 0; i < 100; ++i) {
+      create_file(path / ((i % 2 ? ".f" : "f") + std::to_string(i) +
+                          exts[i % 4]));
+    }
+  }
+}
+
+// names close to the limit of most file systems
+static void make_long(const fs::path& dir, std::size_t scale) {
+  for (std::size_t d = 0; d < 10 * scale; ++d) {
+    const fs::path path = dir / (std::string(120, 'd') + std::to_string(d));
+    fs::create_directories(path);
+    for (std::size_t i = 0; i < 200; ++i) {
+      create_file(path / (std::string(200, 'f') + number(i, 4) + exts[i % 4]));
+    }
+  }
+}
+
+static std::size_t count_entries(const fs::path& dir) {
+  std::size_t count = 0;
+  for (auto it = fs::recursive_directory_iterator(dir);
+       it != fs::recursive_directory_iterator(); ++it) {
+    ++count;
+  }
+  return count;
+}
+
+int main(int argc, char** argv) {
+  const std::size_t scale =
+      argc > 1 ? std::max(std::atoi(argv[1]), 1) : static_cast<std::size_t>(1);
+
+  struct tree {
+    const char* name;
+    void (*make)(const fs::path&, std::size_t);
+  };
+  const tree trees[] = {{"wide", make_wide},
+                        {"deep", make_deep},
+                        {"small", make_small},
+                        {"hidden", make_hidden},
+                        {"long", make_long}};
+
+  const char* const glob_patterns[] = {"*",        "*.txt",   "*/",
+                                       "*/*.cpp",  "**",      "**/*.cpp",
+                                       "**/d1/*",  "**/.*",   "d1/**/f0*"};
+
+  const fs::path old_dir = fs::current_path();
+  const fs::path root = fs::temp_directory_path() /
+                        ("cppglob_bench_" + std::to_string(::getpid()));
+
+  std::printf("%-8s %-10s %-22s %9s %10s %10s %10s\n", "tree", "function",
+              "pattern", "results", "ns/entry", "syscalls", "allocs");
+
+  for (const tree& t : trees) {
+    const fs::path dir = root / t.name;
+    fs::create_directories(dir);
+    t.make(dir, scale);
+  }
+
+  // directories changed within the last second are not cached
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+  for (const tree& t : trees) {
+    const fs::path dir = root / t.name;
+    const std::size_t entries = count_entries(dir);
+    fs::current_path(dir);
+
+    cppglob::glob_options options;
+    options.threads = 4;
+
+    cppglob::glob_context context, cached;
+    cached.cache_listings(1000000);
+    for (const char* pattern : glob_patterns) {
+      const cppglob::pattern pat(pattern, true);
+
+      report(t.name, "glob", pattern, entries,
+             measure([&]() { return cppglob::glob(pat).size(); }));
+
+      report(t.name, "iglob", pattern, entries, measure([&]() {
+               std::size_t count = 0;
+               for (auto it = cppglob::iglob(pat), end = cppglob::iglob();
+                    it != end; ++it) {
+                 ++count;
+               }
+               return count;
+             }));
+
+      report(t.name, "context", pattern, entries,
+             measure([&]() { return context.glob(pat).size(); }));
+
+      report(t.name, "cached", pattern, entries,
+             measure([&]() { return cached.glob(pat).size(); }));
+    }
+
+    // extended groups matched by several walkers at once
+    for (const char* pattern : {"**/!(*.txt)", "**/+(f|[0-9]).@(cpp|h)"}) {
+      const cppglob::pattern pat(pattern, true,
+                                 cppglob::pattern_flags::extglob);
+      report(t.name, "parallel", pattern, entries,
+             measure([&]() { return cppglob::glob(pat, options).size(); }));
+    }
+
+    fs::current_path(old_dir);
+  }
+
+  // filter() over the names of the wide tree
+  std::vector<fs::path> names;
+  for (const auto& entry : fs::directory_iterator(root / "wide")) {
+    names.push_back(entry.path().filename());
+  }
+  const char* const filter_patterns[] = {"*.txt",       "f00*",
+                                         "*[0-9].cpp",  "*1*2*3*",
+                                         "f000001.txt", "[!f]*",
+                                         "[a-f0-9][a-f0-9]*",
+                                         "*0[0-9]*.t?t"};
+
+  for (const char* pattern : filter_patterns) {
+    std::vector<fs::path> copied;
+    report("names", "filter", pattern, names.size(), measure([&]() {
+             copied = names;
+             cppglob::filter(copied, pattern);
+             return copied.size();
+           }));
+  }
+
+  // patterns parsed at compile time
+  std::vector<fs::path> copied;
+  report("names", "static", "*.txt", names.size(), measure([&]() {
+           copied = names;
+           cppglob::filter(copied, CPPGLOB_PATTERN("*.txt"));
+           return copied.size();
+         }));
+  report("names", "static", "[a-f0-9][a-f0-9]*", names.size(), measure([&]() {
+           copied = names;
+           cppglob::filter(copied, CPPGLOB_PATTERN("[a-f0-9][a-f0-9]*"));
+           return copied.size();
+         }));
+
+  // the same names matched at once from a single buffer
+  cppglob::path_list list;
+  for (const fs::path& name : names) {
+    list.push_back(name.native());
+  }
+
+  for (const char* pattern : filter_patterns) {
+    const cppglob::pattern pat(pattern);
+    std::vector<std::uint64_t> bitmap;
+    report("names", "batch", pattern, names.size(),
+           measure([&]() { return pat.match(list, bitmap); }));
+  }
+
+  // extended groups, with negation
+  for (const char* pattern : {"!(*.txt)", "f00+([0-9]).@(txt|cpp)"}) {
+    const cppglob::pattern pat(pattern, false,
+                               cppglob::pattern_flags::extglob);
+    std::vector<std::uint64_t> bitmap;
+    report("names", "extglob", pattern, names.size(),
+           measure([&]() { return pat.match(list, bitmap); }));
+  }
+
+  // letters matching both cases
+  for (const char* pattern : {"*.TXT", "F00[0-9]*"}) {
+    const cppglob::pattern pat(pattern, false,
+                               cppglob::pattern_flags::case_insensitive);
+    std::vector<std::uint64_t> bitmap;
+    report("names", "icase", pattern, names.size(),
+           measure([&]() { return pat.match(list, bitmap); }));
+  }
+
+  // an ignore list matched as a whole, and one pattern after another
+  std::vector<fs::path> ignores;
+  std::vector<cppglob::pattern> singles;
+  for (std::size_t i = 0; i < 100; ++i) {
+    for (const std::string& pattern :
+         {"*.e" + std::to_string(i), "build" + std::to_string(i),
+          "*cache" + std::to_string(i) + "*"}) {
+      ignores.push_back(pattern);
+      singles.emplace_back(pattern);
+    }
+  }
+  const cppglob::pattern_set ignore_set(ignores);
+
+  report("names", "set", "300 patterns", names.size(), measure([&]() {
+           std::size_t count = 0;
+           for (const fs::path& name : names) {
+             count += ignore_set.match_any(name) ? 1 : 0;
+           }
+           return count;
+         }));
+  report("names", "patterns", "300 patterns", names.size(), measure([&]() {
+           std::size_t count = 0;
+           for (const fs::path& name : names) {
+             for (const cppglob::pattern& pat : singles) {
+               if (pat.match(name)) {
+                 ++count;
+                 break;
+               }
+             }
+           }
+           return count;
+         }));
+
+  for (const char* pattern : filter_patterns) {
+    report("-", "translate", pattern, 1,
+           measure([&]() { return cppglob::translate(pattern).size(); }));
+  }
+
+  fs::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,107 @@
+#ifdef CPPGLOB_BUILDING
+#  undef CPPGLOB_BUILDING
+#endif
+
+#include <cstddef>
+#include <cstdio>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <cppglob/fnmatch.hpp>
+
+namespace fs = std::filesystem;
+using bench_clock = std::chrono::steady_clock;
+
+static std::vector<fs::path> make_names(std::size_t count) {
+  static const char* const exts[] = {".cpp", ".h", ".txt", ".o", ".py"};
+  std::vector<fs::path> names;
+  names.reserve(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string name = "module" + std::to_string(i % 97) + "_file" +
+                       std::to_string(i) + exts[i % 5];
+    if (i % 7 == 0) {
+      name = "lib" + name;
+    }
+    if (i % 11 == 0) {
+      name = "test_" + name;
+    }
+    names.emplace_back(name);
+  }
+
+  return names;
+}
+
+// the matching algorithm of filter() before the native engine
+static std::size_t regex_filter(const std::vector<fs::path>& names,
+                                const fs::path& pat) {
+  std::basic_regex<cppglob::char_type> re(
+      cppglob::translate(pat.lexically_normal().native()));
+  std::size_t count = 0;
+  for (auto&& name : names) {
+    if (std::regex_match(name.lexically_normal().native(), re)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static std::size_t native_filter(const std::vector<fs::path>& names,
+                                 const fs::path& pat) {
+  std::vector<fs::path> copied(names);
+  cppglob::filter(copied, pat.native());
+  return copied.size();
+}
+
+template <typename F>
+static double measure(F&& fn, std::size_t& count) {
+  const auto start = bench_clock::now();
+  count = fn();
+  const auto stop = bench_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+int main() {
+  const std::size_t num_names = 200000;
+  const std::vector<fs::path> names = make_names(num_names);
+  const char* const patterns[] = {
+      "*.cpp",          "lib*",       "*test*",  "module1_file1.h",
+      "*[0-9][0-9].h", "module?_*.o", "*_*_*.py", "[!l]*file1*.txt"};
+
+  // baseline cost of copying the name list inside native_filter()
+  std::size_t dummy = 0;
+  const double copy_ns = measure(
+      [&]() { return std::vector<fs::path>(names).size(); }, dummy);
+
+  std::printf("%-18s %10s %14s %14s %8s\n", "pattern", "matches",
+              "regex ns/name", "native ns/name", "speedup");
+
+  for (const char* pattern : patterns) {
+    const fs::path pat(pattern);
+    std::size_t regex_count = 0, native_count = 0;
+
+    const double regex_ns =
+        measure([&]() { return regex_filter(names, pat); }, regex_count);
+    const double native_ns =
+        std::max(measure([&]() { return native_filter(names, pat); },
+                         native_count) -
+                     copy_ns,
+                 1.0);
+
+    if (regex_count != native_count) {
+      std::fprintf(stderr, "result mismatch for %s: %zu != %zu\n", pattern,
+                   regex_count, native_count);
+      return 1;
+    }
+
+    std::printf("%-18s %10zu %14.1f %14.1f %7.1fx\n", pattern, native_count,
+                regex_ns / num_names, native_ns / num_names,
+                regex_ns / native_ns);
+  }
+
+  return 0;
+}
@@ -13,6 +13,8 @@ for the ISO C++ 2017 standard. This support must be enabled \
 with the -std=c++17 or -std=gnu++17 compiler options.
 #endif
 
+#include <string>
+#include <string_view>
 #include <filesystem>
 
 #if defined(_WIN32) && !defined(__CYGWIN__)
@@ -52,6 +54,16 @@ with the -std=c++17 or -std=gnu++17 compiler options.
 
 namespace cppglob {
   namespace fs = std::filesystem;
+
+#ifndef CPPGLOB_IS_WINDOWS
+  using char_type = char;
+  using string_type = std::string;
+  using string_view_type = std::string_view;
+#else
+  using char_type = wchar_t;
+  using string_type = std::wstring;
+  using string_view_type = std::wstring_view;
+#endif
 }  // namespace cppglob
 
 #endif
@@ -32,18 +32,10 @@
 #include <string_view>
 #include <vector>
 #include "config.hpp"
+#include "pattern.hpp"
+#include "pattern_set.hpp"
 
 namespace cppglob {
-#ifndef CPPGLOB_IS_WINDOWS
-  using char_type = char;
-  using string_type = std::string;
-  using string_view_type = std::string_view;
-#else
-  using char_type = wchar_t;
-  using string_type = std::wstring;
-  using string_view_type = std::wstring_view;
-#endif
-
   /**
    * @brief returns the subset of the vector names that matches pat
    * @param names vector of file names
@@ -52,6 +44,21 @@ namespace cppglob {
   CPPGLOB_EXPORT void filter(std::vector<fs::path>& names,
                              const string_view_type& pat);
 
+  /**
+   * @brief returns the subset of the vector names that matches pat
+   * @param names vector of file names
+   * @param pat precompiled pattern
+   */
+  CPPGLOB_EXPORT void filter(std::vector<fs::path>& names, const pattern& pat);
+
+  /**
+   * @brief returns the subset of the vector names that matches any of pats
+   * @param names vector of file names
+   * @param pats set of patterns
+   */
+  CPPGLOB_EXPORT void filter(std::vector<fs::path>& names,
+                             const pattern_set& pats);
+
   /**
    * @brief translate shell PATTERN to regular expression
    * @param pat patten string
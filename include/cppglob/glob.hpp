@@ -28,9 +28,14 @@
 #ifndef CPPGLOB_GLOB_HPP
 #define CPPGLOB_GLOB_HPP
 
+#include <memory_resource>
 #include <vector>
 #include "config.hpp"
 #include "escape.hpp"
+#include "glob_context.hpp"
+#include "options.hpp"
+#include "path_list.hpp"
+#include "pattern.hpp"
 
 namespace cppglob {
   /**
@@ -48,6 +53,77 @@ namespace cppglob {
    */
   CPPGLOB_EXPORT std::vector<fs::path> glob(const fs::path& pathname,
                                             bool recursive = false);
+
+  /**
+   * @brief Return a list of paths matching a precompiled pattern.
+   * @param pat pattern object
+   *
+   * Same as glob(pat.path(), pat.recursive()), but the pattern is not parsed
+   * again.
+   */
+  CPPGLOB_EXPORT std::vector<fs::path> glob(const pattern& pat);
+
+  /**
+   * @brief Return a list of paths matching a precompiled pattern.
+   * @param pat pattern object
+   * @param options traversal options
+   *
+   * With options.threads other than 1 the directories are read in parallel.
+   * The result is the same set of paths as glob(pat).
+   */
+  CPPGLOB_EXPORT std::vector<fs::path> glob(const pattern& pat,
+                                            const glob_options& options);
+
+  /**
+   * @brief Append the paths matching a precompiled pattern to a path_list.
+   * @param pat pattern object
+   * @param results list which receives the paths
+   * @return results
+   *
+   * The paths are the same as those of glob(pat), in the order in which they
+   * are found. Reusing results for several calls (after clear()) avoids any
+   * allocation once its buffers have grown.
+   */
+  CPPGLOB_EXPORT path_list& glob(const pattern& pat, path_list& results);
+
+  /**
+   * @brief Append the paths matching a precompiled pattern to a path_list,
+   * allocating the temporaries of the walk from a memory resource.
+   * @param pat pattern object
+   * @param results list which receives the paths
+   * @param resource resource of the directory stack, the match states and
+   * the dirent buffers
+   * @return results
+   *
+   * The buffers of results keep their own resource. Threads which glob at
+   * the same time with an arena each (e.g. a
+   * std::pmr::monotonic_buffer_resource) do not contend for the global
+   * heap. The pattern itself is not allocated from resource.
+   */
+  CPPGLOB_EXPORT path_list& glob(const pattern& pat, path_list& results,
+                                 std::pmr::memory_resource* resource);
+
+  /**
+   * @brief Return the paths matching a precompiled pattern in a path_list
+   * whose buffers and all temporaries are allocated from a memory resource.
+   * @param pat pattern object
+   * @param resource resource of the results and of the temporaries
+   */
+  CPPGLOB_EXPORT path_list glob(const pattern& pat,
+                                std::pmr::memory_resource* resource);
+
+  /**
+   * @brief Return the paths matching each of several precompiled patterns.
+   * @param patterns pattern objects
+   * @return one list per pattern, in the same order as patterns
+   *
+   * Patterns which start from the same directory (including relative
+   * patterns below the current directory) are matched in a single walk, so
+   * every directory is read only once no matter how many patterns reach it.
+   * Each list holds the same paths as glob(patterns[i]).
+   */
+  CPPGLOB_EXPORT std::vector<std::vector<fs::path>> glob(
+      const std::vector<pattern>& patterns);
 }  // namespace cppglob
 
 #endif
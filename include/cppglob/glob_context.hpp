@@ -0,0 +1,130 @@
+/**
+ * @file cppglob/glob_context.hpp
+ * @brief glob_context class declaration
+ * @copyright 2018 Ryohei Machida
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_GLOB_CONTEXT_HPP
+#define CPPGLOB_GLOB_CONTEXT_HPP
+
+#include <cstddef>
+#include <memory>
+#include "config.hpp"
+#include "path_list.hpp"
+#include "pattern.hpp"
+
+namespace cppglob {
+  namespace detail {
+    struct glob_context_impl;
+  }  // namespace detail
+
+  /**
+   * @brief State kept between glob() calls which are made one after another.
+   *
+   * The context owns a cache of compiled patterns, the directory frames of
+   * the walk (paths, match states and dirent buffers) and a path_list which
+   * receives the results. Once the buffers have grown to the largest walk,
+   * a call with a cached or precompiled pattern makes no heap allocation on
+   * Linux. A context is not thread-safe: use one per thread.
+   *
+   * The listings of the directories can be cached as well (see
+   * cache_listings()), so that a walk over an unchanged tree costs one
+   * fstat(2) per directory instead of reading it.
+   *
+   * @code
+   * cppglob::glob_context context;
+   * for (const cppglob::string_view_type file :
+   *      context.glob(fs::path("src") / "*.cpp")) {
+   *   // ...
+   * }
+   * @endcode
+   */
+  class CPPGLOB_EXPORT glob_context {
+   public:
+    /**
+     * @param cache_size number of compiled patterns which are kept (the
+     * least recently used one is replaced)
+     */
+    explicit glob_context(std::size_t cache_size = 64);
+
+    glob_context(glob_context&& other) noexcept;
+    glob_context& operator=(glob_context&& other) noexcept;
+    ~glob_context();
+
+    /**
+     * @brief Return the cached pattern for the arguments, compiling it if
+     * it is not in the cache.
+     */
+    pattern compile(const fs::path& pathname, bool recursive = false,
+                    pattern_flags flags = pattern_flags::none);
+
+    /**
+     * @brief Return the paths matching a precompiled pattern.
+     * @return list owned by the context, which is valid until the next call
+     *
+     * The paths are the same as those of glob(pat).
+     */
+    const path_list& glob(const pattern& pat);
+
+    /**
+     * @brief Same as glob(compile(pathname, recursive, flags)).
+     */
+    const path_list& glob(const fs::path& pathname, bool recursive = false,
+                          pattern_flags flags = pattern_flags::none);
+
+    /**
+     * @brief Append the paths matching a precompiled pattern to results.
+     * @return results
+     */
+    path_list& glob(const pattern& pat, path_list& results);
+
+    /**
+     * @brief Remove all patterns from the cache.
+     */
+    void clear_cache() noexcept;
+
+    /**
+     * @brief Cache the entries of the directories which are read.
+     * @param max_entries bound of the cached entries, where every directory
+     * counts as one more entry (0 disables the cache)
+     *
+     * Listings are identified by the device and inode of the directory and
+     * are stored with the type of every entry. Before a listing is reused,
+     * the modification time, change time and link count of the directory
+     * are compared with a single fstat(2). Directories changed less than a
+     * second before they were read are not cached, because file systems
+     * with coarse timestamps could miss a later change. The least recently
+     * used listings are dropped first. Calling this again discards the
+     * cached listings. Only available on POSIX systems, elsewhere
+     * directories are always read.
+     */
+    void cache_listings(std::size_t max_entries);
+
+   private:
+    std::unique_ptr<detail::glob_context_impl> M_impl;
+  };
+}  // namespace cppglob
+
+#endif
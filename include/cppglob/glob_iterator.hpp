@@ -30,11 +30,62 @@
 
 #include <cstddef>
 #include <iterator>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <filesystem>
 #include "config.hpp"
+#include "path_list.hpp"
 
 namespace cppglob {
+  namespace detail {
+    /**
+     * @brief producer of the paths yielded by a lazy glob_iterator
+     */
+    class CPPGLOB_LOCAL glob_source {
+     public:
+      virtual ~glob_source() = default;
+
+      /**
+       * @brief store the next path into out
+       * @return false if there are no more paths
+       */
+      virtual bool next(fs::path& out) = 0;
+    };
+
+    /**
+     * @brief glob_source which yields the paths of a path_list
+     */
+    class CPPGLOB_LOCAL path_list_source : public glob_source {
+     public:
+      explicit path_list_source(path_list&& paths) noexcept
+          : M_paths(std::move(paths)) {}
+
+      bool next(fs::path& out) override {
+        if (M_index >= M_paths.size()) {
+          return false;
+        }
+        const string_view_type name = M_paths[M_index++];
+        out.assign(name.begin(), name.end());
+        return true;
+      }
+
+     private:
+      path_list M_paths;
+      std::size_t M_index = 0L;
+    };
+  }  // namespace detail
+
+  /**
+   * @brief Input iterator over the results of iglob().
+   *
+   * An iterator either owns an already materialized list of paths or pulls
+   * the paths one by one from a detail::glob_source, which walks the file
+   * system on demand. Copies of a lazy iterator share the same walk, so
+   * advancing one of them advances all of them. A path_list can also be used
+   * as the materialized list, in which case only the current path is
+   * converted to fs::path.
+   */
   class CPPGLOB_LOCAL glob_iterator {
     using base = std::vector<fs::path>::iterator;
 
@@ -45,7 +96,7 @@ namespace cppglob {
     using const_pointer = const typename fs::path*;
     using reference = typename fs::path&;
     using const_reference = const typename fs::path&;
-    using iterator_category = std::forward_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
 
     glob_iterator() noexcept;
 
@@ -53,6 +104,10 @@ namespace cppglob {
 
     explicit glob_iterator(std::vector<fs::path>&& pathnames) noexcept;
 
+    explicit glob_iterator(path_list&& pathnames);
+
+    explicit glob_iterator(std::shared_ptr<detail::glob_source> source);
+
     glob_iterator(const glob_iterator& other);
 
     glob_iterator(glob_iterator&& other) noexcept;
@@ -81,8 +136,11 @@ namespace cppglob {
     bool finished() const;
 
    private:
+    void fetch();
+
     std::vector<fs::path> M_pathnames;
     std::size_t M_index = 0L;
+    std::shared_ptr<detail::glob_source> M_source;
   };
 
 #if (!defined CPPGLOB_COVERAGE || defined CPPGLOB_BUILDING)
@@ -97,10 +155,21 @@ namespace cppglob {
       std::vector<fs::path>&& pathnames) noexcept
       : M_pathnames(std::move(pathnames)) {}
 
+  CPPGLOB_INLINE glob_iterator::glob_iterator(path_list&& pathnames)
+      : glob_iterator(
+            std::make_shared<detail::path_list_source>(std::move(pathnames))) {}
+
+  CPPGLOB_INLINE glob_iterator::glob_iterator(
+      std::shared_ptr<detail::glob_source> source)
+      : M_pathnames(1), M_source(std::move(source)) {
+    fetch();
+  }
+
   CPPGLOB_INLINE glob_iterator::glob_iterator(const glob_iterator&) = default;
 
   CPPGLOB_INLINE glob_iterator::glob_iterator(glob_iterator&& other) noexcept
-      : M_pathnames(std::move(other.M_pathnames)) {
+      : M_pathnames(std::move(other.M_pathnames)),
+        M_source(std::move(other.M_source)) {
     M_index = other.M_index;
   }
 
@@ -111,29 +180,31 @@ namespace cppglob {
       glob_iterator&& other) {
     M_pathnames = std::move(other.M_pathnames);
     M_index = other.M_index;
+    M_source = std::move(other.M_source);
     return *this;
   }
 
   CPPGLOB_INLINE glob_iterator::reference glob_iterator::operator*() {
-    return M_pathnames[M_index];
+    return M_source ? M_pathnames[0] : M_pathnames[M_index];
   }
   CPPGLOB_INLINE glob_iterator::const_reference glob_iterator::operator*()
       const {
-    return M_pathnames[M_index];
+    return M_source ? M_pathnames[0] : M_pathnames[M_index];
   }
 
   CPPGLOB_INLINE glob_iterator::pointer glob_iterator::operator->() {
-    return &M_pathnames[M_index];
+    return &**this;
   }
   CPPGLOB_INLINE glob_iterator::const_pointer glob_iterator::operator->()
       const {
-    return &M_pathnames[M_index];
+    return &**this;
   }
 
   CPPGLOB_INLINE bool glob_iterator::operator==(
       const glob_iterator& other) const {
     return (finished() && other.finished()) ||
-           (!finished() && !other.finished() && M_index == other.M_index);
+           (!finished() && !other.finished() && M_index == other.M_index &&
+            M_source == other.M_source);
   }
 
   CPPGLOB_INLINE bool glob_iterator::operator!=(
@@ -143,23 +214,36 @@ namespace cppglob {
 
   CPPGLOB_INLINE glob_iterator& glob_iterator::operator++() {
     ++M_index;
+    if (M_source) {
+      fetch();
+    }
     return *this;
   }
 
   CPPGLOB_INLINE glob_iterator glob_iterator::operator++(int) {
     glob_iterator old(*this);
-    ++M_index;
+    ++*this;
     return old;
   }
 
   CPPGLOB_INLINE glob_iterator& glob_iterator::swap(glob_iterator& other) {
     std::swap(M_pathnames, other.M_pathnames);
     std::swap(M_index, other.M_index);
+    std::swap(M_source, other.M_source);
     return *this;
   }
 
   CPPGLOB_INLINE bool glob_iterator::finished() const {
-    return M_pathnames.empty() || M_index >= M_pathnames.size();
+    return !M_source && (M_pathnames.empty() || M_index >= M_pathnames.size());
+  }
+
+  CPPGLOB_INLINE void glob_iterator::fetch() {
+    // the current path of a lazy iterator is kept in M_pathnames[0]
+    if (!M_source->next(M_pathnames[0])) {
+      M_source.reset();
+      M_pathnames.clear();
+      M_index = 0L;
+    }
   }
 
 #endif
@@ -35,6 +35,7 @@
 #include "config.hpp"
 #include "glob_iterator.hpp"
 #include "escape.hpp"
+#include "pattern.hpp"
 
 namespace cppglob {
   /**
@@ -54,6 +55,13 @@ namespace cppglob {
   CPPGLOB_EXPORT glob_iterator iglob(const fs::path& pathname,
                                      bool recursive = false);
 
+  /**
+   * @brief Return an iterator which yields the paths matching a precompiled
+   * pattern.
+   * @param pat pattern object
+   */
+  CPPGLOB_EXPORT glob_iterator iglob(const pattern& pat);
+
   /**
    * @brief Return the end of glob_iterator generated by
    * iglob(pathname, recursive) function.
@@ -0,0 +1,64 @@
+/**
+ * @file cppglob/options.hpp
+ * @brief glob_options declaration
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_OPTIONS_HPP
+#define CPPGLOB_OPTIONS_HPP
+
+#include "config.hpp"
+
+namespace cppglob {
+  /**
+   * @brief Options which control how glob() walks the file system.
+   *
+   * @code
+   * cppglob::glob_options options;
+   * options.threads = 8;
+   * auto files =
+   *     cppglob::glob(cppglob::pattern(fs::path("src") / "**", true), options);
+   * @endcode
+   */
+  struct CPPGLOB_EXPORT glob_options {
+    /**
+     * @brief Number of threads reading directories.
+     *
+     * 1 walks the file system on the calling thread. 0 uses one thread per
+     * hardware thread. With more than one thread, directories are spread over
+     * a work-stealing pool and the results of all threads are merged.
+     */
+    unsigned int threads = 1;
+
+    /**
+     * @brief Return the results in the same order as a single-threaded walk.
+     *
+     * If false, results are returned in the order in which they are found,
+     * which depends on the scheduling of the threads.
+     */
+    bool ordered = true;
+  };
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file cppglob/path_list.hpp
+ * @brief path_list class declaration
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_PATH_LIST_HPP
+#define CPPGLOB_PATH_LIST_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "config.hpp"
+
+namespace cppglob {
+  /**
+   * @brief Compact list of paths.
+   *
+   * All paths are stored back to back in a single character buffer, with
+   * one end offset per path. Appending a path costs no allocation once the
+   * buffers have grown, and the memory overhead per path is a single offset
+   * instead of a separately allocated fs::path. Elements are exposed as
+   * string views into the buffer (not null-terminated), which are
+   * invalidated when the list is modified, or converted to fs::path on
+   * request. Both buffers are allocated from a std::pmr::memory_resource,
+   * e.g. an arena which is released after the results have been used.
+   */
+  class CPPGLOB_EXPORT path_list {
+   public:
+    using value_type = string_view_type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    /**
+     * @brief Random access iterator which yields string views.
+     */
+    class const_iterator {
+     public:
+      using difference_type = path_list::difference_type;
+      using value_type = string_view_type;
+      using pointer = void;
+      using reference = string_view_type;
+      using iterator_category = std::random_access_iterator_tag;
+
+      const_iterator() noexcept = default;
+
+      reference operator*() const { return (*M_list)[M_index]; }
+      reference operator[](difference_type n) const {
+        return (*M_list)[M_index + n];
+      }
+
+      const_iterator& operator++() {
+        ++M_index;
+        return *this;
+      }
+      const_iterator operator++(int) {
+        const_iterator old(*this);
+        ++M_index;
+        return old;
+      }
+      const_iterator& operator--() {
+        --M_index;
+        return *this;
+      }
+      const_iterator operator--(int) {
+        const_iterator old(*this);
+        --M_index;
+        return old;
+      }
+
+      const_iterator& operator+=(difference_type n) {
+        M_index += n;
+        return *this;
+      }
+      const_iterator& operator-=(difference_type n) {
+        M_index -= n;
+        return *this;
+      }
+      const_iterator operator+(difference_type n) const {
+        return const_iterator(M_list, M_index + n);
+      }
+      friend const_iterator operator+(difference_type n,
+                                      const const_iterator& it) {
+        return it + n;
+      }
+      const_iterator operator-(difference_type n) const {
+        return const_iterator(M_list, M_index - n);
+      }
+      difference_type operator-(const const_iterator& other) const {
+        return static_cast<difference_type>(M_index - other.M_index);
+      }
+
+      bool operator==(const const_iterator& other) const {
+        return M_index == other.M_index;
+      }
+      bool operator!=(const const_iterator& other) const {
+        return M_index != other.M_index;
+      }
+      bool operator<(const const_iterator& other) const {
+        return M_index < other.M_index;
+      }
+      bool operator>(const const_iterator& other) const {
+        return M_index > other.M_index;
+      }
+      bool operator<=(const const_iterator& other) const {
+        return M_index <= other.M_index;
+      }
+      bool operator>=(const const_iterator& other) const {
+        return M_index >= other.M_index;
+      }
+
+     private:
+      friend class path_list;
+
+      const_iterator(const path_list* list, size_type index) noexcept
+          : M_list(list), M_index(index) {}
+
+      const path_list* M_list = nullptr;
+      size_type M_index = 0L;
+    };
+
+    using iterator = const_iterator;
+
+    path_list() noexcept = default;
+
+    /**
+     * @brief Construct an empty list whose buffers are allocated from
+     * resource.
+     */
+    explicit path_list(std::pmr::memory_resource* resource) noexcept
+        : M_buffer(resource), M_ends(resource) {}
+
+    /**
+     * @brief Return the memory resource of the buffers.
+     */
+    std::pmr::memory_resource* resource() const noexcept {
+      return M_ends.get_allocator().resource();
+    }
+
+    size_type size() const noexcept { return M_ends.size(); }
+    bool empty() const noexcept { return M_ends.empty(); }
+
+    /**
+     * @brief Return the i-th path as a view into the buffer.
+     */
+    string_view_type operator[](size_type i) const noexcept {
+      const size_type first = i == 0 ? 0L : M_ends[i - 1];
+      return string_view_type(M_buffer.data() + first, M_ends[i] - first);
+    }
+
+    /**
+     * @brief Return a copy of the i-th path.
+     */
+    fs::path path(size_type i) const;
+
+    /**
+     * @brief Return the buffer holding all paths back to back.
+     */
+    string_view_type buffer() const noexcept { return M_buffer; }
+
+    /**
+     * @brief Return the end offset of each path in buffer().
+     */
+    const std::pmr::vector<size_type>& ends() const noexcept {
+      return M_ends;
+    }
+
+    const_iterator begin() const noexcept { return const_iterator(this, 0L); }
+    const_iterator end() const noexcept {
+      return const_iterator(this, size());
+    }
+
+    /**
+     * @brief Append a path.
+     */
+    void push_back(const string_view_type& pathname);
+
+    /**
+     * @brief Reserve room for count paths with length characters in total.
+     */
+    void reserve(size_type count, size_type length);
+
+    /**
+     * @brief Remove all paths, keeping the allocated buffers.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Return a copy of all paths as separate fs::path objects.
+     */
+    std::vector<fs::path> to_vector() const;
+
+   private:
+    std::pmr::basic_string<char_type> M_buffer;
+    std::pmr::vector<size_type> M_ends;
+  };
+}  // namespace cppglob
+
+#endif
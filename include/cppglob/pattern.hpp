@@ -0,0 +1,198 @@
+/**
+ * @file cppglob/pattern.hpp
+ * @brief pattern class declaration
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_PATTERN_HPP
+#define CPPGLOB_PATTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "config.hpp"
+#include "path_list.hpp"
+
+namespace cppglob {
+  namespace detail {
+    struct compiled_pattern;
+    struct pattern_access;
+
+    /**
+     * @brief test whether lexically_normal() would return str unchanged
+     *
+     * Conservative: some normal paths (e.g. ".") are reported as not normal.
+     */
+    constexpr bool is_normal(const string_view_type& str) {
+      constexpr char_type sep = fs::path::preferred_separator;
+#ifdef CPPGLOB_IS_WINDOWS
+      if (str.find_first_of(L"/:") != string_view_type::npos) {
+        return false;
+      }
+#endif
+      const std::size_t n = str.size();
+      std::size_t first = 0L;
+
+      while (first <= n) {
+        std::size_t last = str.find(sep, first);
+        if (last == string_view_type::npos) {
+          last = n;
+        }
+
+        const std::size_t len = last - first;
+        if (len == 0) {
+          // only a single root separator or a trailing separator
+          if (first == 0 ? n > 1 && str[1] == sep : last != n) {
+            return false;
+          }
+        } else if (str[first] == '.' &&
+                   (len == 1 || (len == 2 && str[first + 1] == '.'))) {
+          return false;
+        }
+
+        first = last + 1;
+      }
+
+      return true;
+    }
+  }  // namespace detail
+
+  /**
+   * @brief Optional extensions of the pattern syntax, combined with '|'.
+   */
+  enum class pattern_flags : unsigned int {
+    none = 0,
+
+    /**
+     * @brief Expand "{a,b}" and "{1..10}" like the shell.
+     *
+     * Braces may be nested, and sequences may have a step ("{0..10..2}"),
+     * leading zeros ("{01..10}") or letters ("{a..f}"). A brace without a
+     * comma or a sequence is literal, and "[{]" matches '{' itself. All
+     * alternatives are matched in a single walk which reads every directory
+     * only once, and a path matched by several alternatives is returned
+     * once.
+     */
+    braces = 1U << 0,
+
+    /**
+     * @brief Recognize the extended groups of ksh (bash extglob).
+     *
+     * "?(a|b)" matches zero or one, "*(a|b)" zero or more, "+(a|b)" one or
+     * more and "@(a|b)" exactly one of the alternatives, and "!(a|b)"
+     * matches anything except them. Groups may be nested and contain
+     * wildcards. They are matched by a lazily built DFA, in linear time
+     * even with negation.
+     */
+    extglob = 1U << 1,
+
+    /**
+     * @brief Match names regardless of case.
+     *
+     * Letters of the pattern match each of their case variants (Unicode
+     * simple case folding), and the names read from directories are not
+     * converted. Bracket expressions ignore case as well. Literal
+     * components are looked up directly only where the file system itself
+     * ignores case (Windows and macOS).
+     */
+    case_insensitive = 1U << 2
+  };
+
+  constexpr pattern_flags operator|(pattern_flags lhs, pattern_flags rhs) {
+    return static_cast<pattern_flags>(static_cast<unsigned int>(lhs) |
+                                      static_cast<unsigned int>(rhs));
+  }
+
+  constexpr pattern_flags operator&(pattern_flags lhs, pattern_flags rhs) {
+    return static_cast<pattern_flags>(static_cast<unsigned int>(lhs) &
+                                      static_cast<unsigned int>(rhs));
+  }
+
+  /**
+   * @brief Shell pattern which is parsed and compiled only once.
+   *
+   * The pathname is split into its directory components, every component is
+   * classified as literal, magic or recursive ('**') and magic components
+   * are compiled into matchers. The object is immutable, so it can be shared
+   * between threads and passed to glob(), iglob() and filter() as many times
+   * as needed.
+   */
+  class CPPGLOB_EXPORT pattern {
+   public:
+    /**
+     * @brief Construct a pattern which matches nothing.
+     */
+    pattern();
+
+    /**
+     * @brief Compile a pathname pattern.
+     * @param pathname pattern string
+     * @param recursive allow recursive pattern string
+     * @param flags syntax extensions
+     */
+    explicit pattern(const fs::path& pathname, bool recursive = false,
+                     pattern_flags flags = pattern_flags::none);
+
+    /**
+     * @brief Return the pathname this pattern was compiled from.
+     */
+    const fs::path& path() const noexcept;
+
+    /**
+     * @brief Return true if '**' matches zero or more directories.
+     */
+    bool recursive() const noexcept;
+
+    /**
+     * @brief Return the syntax extensions this pattern was compiled with.
+     */
+    pattern_flags flags() const noexcept;
+
+    /**
+     * @brief Test whether the whole name matches this pattern with the same
+     * rules as filter().
+     * @param name file name
+     */
+    bool match(const fs::path& name) const;
+
+    /**
+     * @brief Test all names of a list at once, e.g. the entries of a
+     * directory.
+     * @param names names to be tested
+     * @param bitmap receives one bit per name: name i matches if bit
+     * (i % 64) of bitmap[i / 64] is set
+     * @return number of matching names
+     */
+    std::size_t match(const path_list& names,
+                      std::vector<std::uint64_t>& bitmap) const;
+
+   private:
+    friend struct detail::pattern_access;
+
+    std::shared_ptr<const detail::compiled_pattern> M_impl;
+  };
+}  // namespace cppglob
+
+#endif
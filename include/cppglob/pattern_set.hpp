@@ -0,0 +1,98 @@
+/**
+ * @file cppglob/pattern_set.hpp
+ * @brief pattern_set class declaration
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_PATTERN_SET_HPP
+#define CPPGLOB_PATTERN_SET_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "config.hpp"
+
+namespace cppglob {
+  namespace detail {
+    struct pattern_set_impl;
+  }  // namespace detail
+
+  /**
+   * @brief Many shell patterns matched against a name at once.
+   *
+   * The longest literal which every name matched by a pattern must contain
+   * is extracted from each pattern, and all of them are compiled into a
+   * single Aho-Corasick automaton. A name is scanned once, and only the
+   * patterns whose literal occurs in it, plus those without any literal
+   * such as "*" or "?.[ch]", are confirmed with their own matcher. The cost
+   * is therefore close to independent of the number of patterns. The object
+   * is immutable and can be shared between threads.
+   */
+  class CPPGLOB_EXPORT pattern_set {
+   public:
+    /**
+     * @brief Construct an empty set.
+     */
+    pattern_set();
+
+    /**
+     * @brief Compile patterns, which are identified by their index.
+     * @param patterns pattern strings
+     */
+    explicit pattern_set(const std::vector<fs::path>& patterns);
+
+    /**
+     * @brief Return the number of patterns.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * @brief Return the pattern with the given ID.
+     */
+    const fs::path& path(std::size_t id) const;
+
+    /**
+     * @brief Return the IDs of the patterns which match the whole name, in
+     * increasing order, with the same rules as filter().
+     * @param name file name
+     */
+    std::vector<std::size_t> matches(const fs::path& name) const;
+
+    /**
+     * @brief Same as matches(name), but reuses the storage of ids.
+     */
+    void matches(const fs::path& name, std::vector<std::size_t>& ids) const;
+
+    /**
+     * @brief Test whether any pattern matches the whole name.
+     * @param name file name
+     */
+    bool match_any(const fs::path& name) const;
+
+   private:
+    std::shared_ptr<const detail::pattern_set_impl> M_impl;
+  };
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,341 @@
+/**
+ * @file cppglob/static_pattern.hpp
+ * @brief static_pattern class declaration
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_STATIC_PATTERN_HPP
+#define CPPGLOB_STATIC_PATTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "config.hpp"
+#include "glob.hpp"
+#include "glob_iterator.hpp"
+#include "iglob.hpp"
+#include "pattern.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief single character test of a pattern parsed at compile time
+     */
+    struct static_token {
+      enum kind_type : unsigned char { literal, any, bracket };
+
+      kind_type kind = literal;
+      char_type ch = 0;
+
+      // bracket: characters below 256, and the contents in the source for
+      // wider characters
+      bool negated = false;
+      std::uint64_t bits[4] = {};
+      std::size_t first = 0L;
+      std::size_t last = 0L;
+    };
+
+    /**
+     * @brief tokens of a pattern of at most N characters, split at the
+     * stars like the matcher of cppglob::pattern
+     */
+    template <std::size_t N>
+    struct static_program {
+      static_token tokens[N + 1];
+      std::size_t count = 0L;
+
+      // end offsets of each segment in tokens
+      std::size_t bounds[N + 1] = {};
+      std::size_t segments = 0L;
+    };
+
+    /**
+     * @brief test whether c is in one of the ranges of a bracket expression
+     * (negation is not applied)
+     */
+    constexpr bool in_ranges(const string_view_type& stuff, char_type c) {
+      std::size_t k = 0L, n = stuff.size();
+      if (n > 0 && stuff[0] == '!') {
+        ++k;
+      }
+
+      while (k < n) {
+        if (k + 2 < n && stuff[k + 1] == '-') {
+          if (stuff[k] <= c && c <= stuff[k + 2]) {
+            return true;
+          }
+          k += 3;
+        } else {
+          if (stuff[k] == c) {
+            return true;
+          }
+          ++k;
+        }
+      }
+
+      return false;
+    }
+
+    template <std::size_t N>
+    constexpr static_program<N> parse_static(const string_view_type& pat) {
+      using uchar = std::make_unsigned_t<char_type>;
+      static_program<N> prog{};
+      std::size_t i = 0L, n = pat.size();
+      bool star = false;
+
+      while (i < n) {
+        const char_type c = pat[i];
+        ++i;
+
+        if (c == '*') {
+          // consecutive stars are the same as a single one
+          if (!star) {
+            prog.bounds[prog.segments++] = prog.count;
+          }
+          star = true;
+          continue;
+        }
+        star = false;
+
+        static_token& tok = prog.tokens[prog.count++];
+        tok.ch = c;
+
+        if (c == '?') {
+          tok.kind = static_token::any;
+        } else if (c == '[') {
+          // bracket expressions are delimited exactly like translate() does
+          std::size_t j = i;
+          if (j < n && pat[j] == '!') {
+            ++j;
+          }
+          if (j < n && pat[j] == ']') {
+            ++j;
+          }
+          while (j < n && pat[j] != ']') {
+            ++j;
+          }
+
+          if (j < n) {
+            const string_view_type stuff = pat.substr(i, j - i);
+            tok.kind = static_token::bracket;
+            tok.negated = !stuff.empty() && stuff[0] == '!';
+            tok.first = i;
+            tok.last = j;
+            for (unsigned int u = 0; u < 256; ++u) {
+              const auto ch = static_cast<char_type>(static_cast<uchar>(u));
+              if (in_ranges(stuff, ch) != tok.negated) {
+                tok.bits[u / 64] |= std::uint64_t(1) << (u % 64);
+              }
+            }
+            i = j + 1;
+          }
+        }
+      }
+
+      prog.bounds[prog.segments++] = prog.count;
+      return prog;
+    }
+  }  // namespace detail
+
+  /**
+   * @brief Shell pattern parsed at compile time.
+   *
+   * Source is a type with a static constexpr function value() returning the
+   * pattern, which is most easily created with CPPGLOB_PATTERN(). The
+   * pattern is turned into a constant program when the code is compiled, so
+   * that match() has no parse cost and can be inlined and evaluated in
+   * constant expressions. glob() and iglob() compile the pattern only once
+   * per program.
+   */
+  template <typename Source>
+  class static_pattern {
+   public:
+    /**
+     * @brief Return the pattern string.
+     */
+    static constexpr string_view_type source() noexcept {
+      return Source::value();
+    }
+
+    /**
+     * @brief Test whether the whole name matches this pattern with the same
+     * rules as pattern::match().
+     * @param name file name
+     */
+    static constexpr bool match(const string_view_type& name) {
+      static_assert(detail::is_normal(source()),
+                    "static patterns must be in normal form");
+
+      if (detail::is_normal(name)) {
+        return match_normal(name);
+      }
+      return match_normal(fs::path(name).lexically_normal().native());
+    }
+
+    /**
+     * @brief Return the pattern compiled at run time, for glob() and
+     * iglob(). The pattern is compiled at the first call.
+     */
+    static const pattern& compiled(bool recursive = false) {
+      if (recursive) {
+        static const pattern pat(fs::path(source()), true);
+        return pat;
+      }
+      static const pattern pat{fs::path(source())};
+      return pat;
+    }
+
+   private:
+    static constexpr std::size_t size = Source::value().size();
+    static constexpr detail::static_program<size> program =
+        detail::parse_static<size>(Source::value());
+
+    static constexpr bool contains(const detail::static_token& tok,
+                                   char_type c) {
+      const auto u = static_cast<std::make_unsigned_t<char_type>>(c);
+      if constexpr (sizeof(char_type) > 1) {
+        if (u >= 256) {
+          return detail::in_ranges(source().substr(tok.first,
+                                                   tok.last - tok.first),
+                                   c) != tok.negated;
+        }
+      }
+      return ((tok.bits[u / 64] >> (u % 64)) & 1) != 0;
+    }
+
+    static constexpr bool match_at(std::size_t first, std::size_t last,
+                                   const char_type* s) {
+      for (std::size_t i = first; i < last; ++i, ++s) {
+        const detail::static_token& tok = program.tokens[i];
+        switch (tok.kind) {
+          case detail::static_token::literal:
+            if (*s != tok.ch) return false;
+            break;
+          case detail::static_token::bracket:
+            if (!contains(tok, *s)) return false;
+            break;
+          default:
+            break;
+        }
+      }
+      return true;
+    }
+
+    static constexpr bool match_normal(const string_view_type& name) {
+      const std::size_t stars = program.segments - 1;
+      const std::size_t n = name.size();
+      const std::size_t head_len = program.bounds[0];
+
+      if (stars == 0) {
+        return n == head_len && match_at(0L, head_len, name.data());
+      }
+
+      const std::size_t tail_first = program.bounds[stars - 1];
+      const std::size_t tail_len = program.count - tail_first;
+
+      if (n < head_len + tail_len || !match_at(0L, head_len, name.data()) ||
+          !match_at(tail_first, program.count,
+                    name.data() + n - tail_len)) {
+        return false;
+      }
+
+      // middle segments at their leftmost positions
+      std::size_t pos = head_len;
+      const std::size_t end = n - tail_len;
+
+      for (std::size_t i = 1; i < stars; ++i) {
+        const std::size_t first = program.bounds[i - 1];
+        const std::size_t last = program.bounds[i];
+        const std::size_t len = last - first;
+
+        while (pos + len <= end && !match_at(first, last, name.data() + pos)) {
+          ++pos;
+        }
+        if (pos + len > end) {
+          return false;
+        }
+        pos += len;
+      }
+
+      return true;
+    }
+  };
+
+  /**
+   * @brief Return a list of paths matching a pattern parsed at compile time.
+   * @param pat pattern object
+   * @param recursive allow recursive pattern string
+   */
+  template <typename Source>
+  std::vector<fs::path> glob(const static_pattern<Source>& pat,
+                             bool recursive = false) {
+    return glob(pat.compiled(recursive));
+  }
+
+  /**
+   * @brief Return an iterator which yields the paths matching a pattern
+   * parsed at compile time.
+   * @param pat pattern object
+   * @param recursive allow recursive pattern string
+   */
+  template <typename Source>
+  glob_iterator iglob(const static_pattern<Source>& pat,
+                      bool recursive = false) {
+    return iglob(pat.compiled(recursive));
+  }
+
+  /**
+   * @brief returns the subset of the vector names that matches pat
+   * @param names vector of file names
+   * @param pat pattern parsed at compile time
+   */
+  template <typename Source>
+  void filter(std::vector<fs::path>& names,
+              const static_pattern<Source>& pat) {
+    auto result =
+        std::remove_if(names.begin(), names.end(), [&pat](const fs::path& p) {
+          return !pat.match(p.native());
+        });
+    names.erase(result, names.end());
+  }
+}  // namespace cppglob
+
+/**
+ * @brief Create a cppglob::static_pattern from a string literal.
+ *
+ * e.g. cppglob::filter(names, CPPGLOB_PATTERN("*.tar.gz"))
+ */
+#define CPPGLOB_PATTERN(str)                                     \
+  ([] {                                                          \
+    struct cppglob_pattern_source {                              \
+      static constexpr ::cppglob::string_view_type value() {     \
+        return str;                                              \
+      }                                                          \
+    };                                                           \
+    return ::cppglob::static_pattern<cppglob_pattern_source>();  \
+  }())
+
+#endif
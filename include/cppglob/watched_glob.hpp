@@ -0,0 +1,139 @@
+/**
+ * @file cppglob/watched_glob.hpp
+ * @brief watched_glob class declaration
+ * @copyright 2018 Ryohei Machida
+ * @copyright 2018 Ryohei Machida
+ *
+ * @par License
+ * @parblock
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * @endparblock
+ */
+
+#ifndef CPPGLOB_WATCHED_GLOB_HPP
+#define CPPGLOB_WATCHED_GLOB_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include "config.hpp"
+#include "pattern.hpp"
+
+#if defined(__linux__)
+#  define CPPGLOB_HAS_WATCHED_GLOB 1
+#endif
+
+#ifdef CPPGLOB_HAS_WATCHED_GLOB
+
+namespace cppglob {
+  namespace detail {
+    class watched_glob_impl;
+  }  // namespace detail
+
+  /**
+   * @brief Paths matching a pattern, kept up to date with inotify(7).
+   *
+   * The directories are walked once when the object is constructed, and
+   * every directory which the pattern can reach (the directories the walk
+   * of glob() enters) is watched. Afterwards poll() only reads the events
+   * of the watched directories and matches the names they report, so its
+   * cost is proportional to the number of changes and not to the size of
+   * the tree. A new subdirectory is walked and watched when it appears, and
+   * the results below a directory which is removed or renamed are dropped.
+   * If the event queue of the kernel overflows, the whole tree is walked
+   * again.
+   *
+   * The results are the same paths as those of glob(pat). A root directory
+   * (the leading part of the pattern without magic, or the parent of a
+   * pattern without magic) which does not exist or is removed is waited for
+   * in its nearest existing ancestor, and walked again when it is created.
+   * Renaming a directory above an existing root is not noticed, and
+   * relative patterns refer to the current directory at the time of each
+   * walk. Only available on Linux (CPPGLOB_HAS_WATCHED_GLOB is defined).
+   *
+   * @code
+   * cppglob::watched_glob jobs(cppglob::pattern(fs::path("spool") / "*.job"));
+   * while (jobs.poll(-1)) {
+   *   for (const fs::path& job : jobs.added()) {
+   *     // ...
+   *   }
+   * }
+   * @endcode
+   */
+  class CPPGLOB_EXPORT watched_glob {
+   public:
+    /**
+     * @brief walk the directories reachable by pat and watch them
+     * @throw std::system_error if inotify is not available or the limit of
+     * watches is reached
+     */
+    explicit watched_glob(const pattern& pat);
+
+    watched_glob(watched_glob&& other) noexcept;
+    watched_glob& operator=(watched_glob&& other) noexcept;
+    ~watched_glob();
+
+    /**
+     * @brief Apply the pending changes to the results.
+     * @param timeout_ms milliseconds to wait for a change (0 returns at
+     * once, -1 waits forever)
+     * @return true if any path was added or removed
+     *
+     * added() and removed() are replaced by the changes of this call. A
+     * path which appears and disappears again within a call is in neither.
+     */
+    bool poll(int timeout_ms = 0);
+
+    /**
+     * @brief paths which started matching during the last poll(), sorted
+     * by their native strings
+     */
+    const std::vector<fs::path>& added() const noexcept;
+
+    /**
+     * @brief paths which stopped matching during the last poll(), sorted
+     * by their native strings
+     */
+    const std::vector<fs::path>& removed() const noexcept;
+
+    /**
+     * @brief all paths matching the pattern, sorted by their native strings
+     */
+    std::vector<fs::path> snapshot() const;
+
+    /**
+     * @brief number of paths matching the pattern
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * @brief inotify file descriptor, which becomes readable when poll()
+     * has changes to read (for use with select(2), poll(2) or epoll(7))
+     */
+    int native_handle() const noexcept;
+
+   private:
+    std::unique_ptr<detail::watched_glob_impl> M_impl;
+  };
+}  // namespace cppglob
+
+#endif
+
+#endif
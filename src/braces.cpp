@@ -0,0 +1,273 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "braces.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief return the position after the bracket expression starting at
+     * pos, or pos + 1 if it is not closed
+     */
+    CPPGLOB_INLINE std::size_t skip_bracket(const string_type& str,
+                                            std::size_t pos) {
+      std::size_t i = pos + 1;
+      if (i < str.size() && str[i] == '!') {
+        ++i;
+      }
+      if (i < str.size() && str[i] == ']') {
+        ++i;
+      }
+      while (i < str.size() && str[i] != ']') {
+        ++i;
+      }
+      return i < str.size() ? i + 1 : pos + 1;
+    }
+
+    /**
+     * @brief find the brace closing the one at open
+     * @param commas receives the positions of the top-level commas
+     * @return position of the closing brace, or npos
+     */
+    CPPGLOB_INLINE std::size_t find_close(const string_type& str,
+                                          std::size_t open,
+                                          std::vector<std::size_t>& commas) {
+      std::size_t depth = 0L;
+      std::size_t i = open;
+
+      while (i < str.size()) {
+        const char_type c = str[i];
+        if (c == '[') {
+          i = skip_bracket(str, i);
+          continue;
+        }
+
+        if (c == '{') {
+          ++depth;
+        } else if (c == '}') {
+          if (--depth == 0) {
+            return i;
+          }
+        } else if (c == ',' && depth == 1) {
+          commas.push_back(i);
+        }
+        ++i;
+      }
+
+      return string_type::npos;
+    }
+
+    CPPGLOB_INLINE bool is_digit(char_type c) { return c >= '0' && c <= '9'; }
+
+    /**
+     * @brief parse an optionally negative decimal integer
+     */
+    CPPGLOB_INLINE bool parse_integer(const string_type& str, long long& value,
+                                      bool& padded) {
+      const std::size_t sign = !str.empty() && str[0] == '-' ? 1 : 0;
+      // sequences beyond 18 digits would overflow while counting
+      if (str.size() == sign || str.size() - sign > 18) {
+        return false;
+      }
+
+      value = 0;
+      for (std::size_t i = sign; i < str.size(); ++i) {
+        if (!is_digit(str[i])) {
+          return false;
+        }
+        value = value * 10 + (str[i] - '0');
+      }
+
+      if (sign != 0) {
+        value = -value;
+      }
+      padded = str.size() - sign > 1 && str[sign] == '0';
+      return true;
+    }
+
+    CPPGLOB_INLINE string_type format_integer(long long value,
+                                              std::size_t width) {
+      const bool negative = value < 0;
+      unsigned long long magnitude =
+          negative ? 0ULL - static_cast<unsigned long long>(value)
+                   : static_cast<unsigned long long>(value);
+
+      string_type digits;
+      do {
+        digits.insert(digits.begin(), char_type('0' + magnitude % 10));
+        magnitude /= 10;
+      } while (magnitude != 0);
+
+      // the width of the bounds includes their sign
+      const std::size_t len = digits.size() + (negative ? 1 : 0);
+      if (len < width) {
+        digits.insert(0, width - len, char_type('0'));
+      }
+      if (negative) {
+        digits.insert(digits.begin(), char_type('-'));
+      }
+      return digits;
+    }
+
+    /**
+     * @brief expand a sequence "x..y" or "x..y..step" of integers or
+     * characters
+     * @return false if body is not a sequence
+     */
+    CPPGLOB_INLINE bool expand_sequence(const string_type& body,
+                                        std::vector<string_type>& items) {
+      std::vector<string_type> parts;
+      std::size_t first = 0L;
+      while (true) {
+        const std::size_t dots = body.find(CStr(".."), first);
+        parts.push_back(body.substr(first, dots - first));
+        if (dots == string_type::npos) {
+          break;
+        }
+        first = dots + 2;
+      }
+
+      if (parts.size() != 2 && parts.size() != 3) {
+        return false;
+      }
+
+      long long step = 1;
+      bool padded = false;
+      if (parts.size() == 3) {
+        if (!parse_integer(parts[2], step, padded)) {
+          return false;
+        }
+        if (step < 0) {
+          step = -step;
+        } else if (step == 0) {
+          step = 1;
+        }
+      }
+
+      long long from, to;
+      bool padded_from, padded_to;
+      if (parse_integer(parts[0], from, padded_from) &&
+          parse_integer(parts[1], to, padded_to)) {
+        std::size_t width = 0L;
+        if (padded_from || padded_to) {
+          width = std::max(parts[0].size(), parts[1].size());
+        }
+
+        if (from <= to) {
+          for (long long i = from; i <= to; i += step) {
+            items.push_back(format_integer(i, width));
+          }
+        } else {
+          for (long long i = from; i >= to; i -= step) {
+            items.push_back(format_integer(i, width));
+          }
+        }
+        return true;
+      }
+
+      if (parts[0].size() != 1 || parts[1].size() != 1 ||
+          is_digit(parts[0][0]) || is_digit(parts[1][0])) {
+        return false;
+      }
+
+      const long long a = parts[0][0];
+      const long long b = parts[1][0];
+      if (a <= b) {
+        for (long long c = a; c <= b; c += step) {
+          items.emplace_back(1, char_type(c));
+        }
+      } else {
+        for (long long c = a; c >= b; c -= step) {
+          items.emplace_back(1, char_type(c));
+        }
+      }
+      return true;
+    }
+
+    CPPGLOB_INLINE void expand_from(const string_type& str, std::size_t pos,
+                                    std::vector<string_type>& results) {
+      std::vector<std::size_t> commas;
+      std::vector<string_type> items;
+
+      while (pos < str.size()) {
+        if (str[pos] == '[') {
+          pos = skip_bracket(str, pos);
+          continue;
+        }
+        if (str[pos] != '{') {
+          ++pos;
+          continue;
+        }
+
+        commas.clear();
+        items.clear();
+        const std::size_t close = find_close(str, pos, commas);
+        if (close == string_type::npos) {
+          // an unbalanced brace is literal
+          ++pos;
+          continue;
+        }
+
+        if (!commas.empty()) {
+          std::size_t first = pos + 1;
+          for (const std::size_t comma : commas) {
+            items.push_back(str.substr(first, comma - first));
+            first = comma + 1;
+          }
+          items.push_back(str.substr(first, close - first));
+        } else if (!expand_sequence(str.substr(pos + 1, close - pos - 1),
+                                    items)) {
+          // a literal brace, but braces inside it may still expand
+          ++pos;
+          continue;
+        }
+
+        // the alternatives are rescanned for nested braces, the prefix is
+        // known to have none
+        const string_view_type prefix(str.data(), pos);
+        const string_view_type suffix(str.data() + close + 1,
+                                      str.size() - close - 1);
+        for (const string_type& item : items) {
+          string_type expanded;
+          expanded.reserve(prefix.size() + item.size() + suffix.size());
+          expanded.append(prefix.data(), prefix.size());
+          expanded.append(item);
+          expanded.append(suffix.data(), suffix.size());
+          expand_from(expanded, pos, results);
+        }
+        return;
+      }
+
+      results.push_back(str);
+    }
+  }  // namespace detail
+
+  std::vector<string_type> detail::expand_braces(const string_type& pattern) {
+    std::vector<string_type> results;
+    expand_from(pattern, 0L, results);
+    return results;
+  }
+}  // namespace cppglob
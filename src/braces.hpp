@@ -0,0 +1,46 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_BRACES_HPP
+#define CPPGLOB_SRC_BRACES_HPP
+
+#include <vector>
+#include <cppglob/config.hpp>
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief expand the braces of a pattern like the shell
+     *
+     * "{a,b}" gives one alternative per comma separated part, and "{1..3}",
+     * "{01..10..3}" or "{a..f}" give a sequence. Braces may be nested, and
+     * the alternatives are returned in the order of the shell. A brace
+     * without a top-level comma or a valid sequence is literal, and so is
+     * a brace inside a bracket expression. A pattern without braces gives
+     * itself.
+     */
+    CPPGLOB_LOCAL std::vector<string_type> expand_braces(
+        const string_type& pattern);
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_CASE_FOLD_HPP
+#define CPPGLOB_SRC_CASE_FOLD_HPP
+
+#include <cstddef>
+#include <cppglob/config.hpp>
+
+namespace cppglob {
+  namespace detail {
+    // no character has more case variants than this
+    constexpr std::size_t max_case_variants = 8;
+
+    CPPGLOB_LOCAL char32_t fold_non_ascii(char32_t c);
+
+    /**
+     * @brief simple case folding of a code point (status C and S of the
+     * Unicode CaseFolding.txt); ASCII is folded without a table lookup
+     */
+    CPPGLOB_INLINE char32_t fold_case(char32_t c) {
+      if (c < 0x80) {
+        return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+      }
+      return fold_non_ascii(c);
+    }
+
+    /**
+     * @brief store every character which folds to the same character as c,
+     * c included, into variants
+     *
+     * Narrow characters are UTF-8 code units, so only ASCII letters have
+     * variants on POSIX systems. Wide characters are UTF-16 code units.
+     * @return number of variants (at least 1)
+     */
+    CPPGLOB_LOCAL std::size_t case_variants(char_type c, char_type* variants);
+
+    /**
+     * @brief append str to out with the case of every character folded
+     * (UTF-8 on POSIX systems, UTF-16 on Windows)
+     *
+     * Invalid sequences are copied unchanged.
+     */
+    CPPGLOB_LOCAL void fold_string(const string_view_type& str,
+                                   string_type& out);
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include "dir_reader.hpp"
+
+#if defined(CPPGLOB_USE_GETDENTS) || defined(CPPGLOB_USE_FDOPENDIR)
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#ifdef CPPGLOB_USE_GETDENTS
+#  include <sys/syscall.h>
+#endif
+
+namespace cppglob {
+  detail::dir_reader::dir_reader(const fs::path& dirname) : dir_reader() {
+    open(dirname);
+  }
+
+  detail::dir_reader::dir_reader(const dir_reader& parent,
+                                 const dir_entry& entry)
+      : dir_reader() {
+    open(parent, entry);
+  }
+
+  detail::dir_reader::dir_reader(const dir_reader& parent,
+                                 const fs::path& name)
+      : dir_reader() {
+    open(parent, name);
+  }
+
+  void detail::dir_reader::open(const dir_reader& parent,
+                                const dir_entry& entry) {
+    // the name points into the dirent buffer and is null-terminated
+    close();
+    open_at(parent, entry.name.data());
+  }
+
+  void detail::dir_reader::open(const dir_reader& parent,
+                                const fs::path& name) {
+    close();
+    open_at(parent, name.c_str());
+  }
+
+#if defined(CPPGLOB_USE_GETDENTS) || defined(CPPGLOB_USE_FDOPENDIR)
+  namespace detail {
+    constexpr int open_dir_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+    CPPGLOB_INLINE bool is_dot_or_dotdot(const char* name) {
+      return name[0] == '.' &&
+             (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+    }
+
+    CPPGLOB_INLINE entry_type to_entry_type(unsigned char d_type) {
+      switch (d_type) {
+        case DT_DIR:
+          return entry_type::directory;
+        case DT_LNK:
+          return entry_type::symlink;
+        case DT_UNKNOWN:
+          return entry_type::unknown;
+        default:
+          return entry_type::other;
+      }
+    }
+
+    CPPGLOB_INLINE bool stat_is_directory(int dirfd, const char* name) {
+      struct stat st;
+      return ::fstatat(dirfd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+    }
+  }  // namespace detail
+
+  bool detail::dir_reader::is_open() const noexcept { return M_fd >= 0; }
+
+  bool detail::dir_reader::is_directory(const dir_entry& entry) const {
+    switch (entry.type) {
+      case entry_type::directory:
+        return true;
+      case entry_type::other:
+        return false;
+      default:
+        // DT_LNK and DT_UNKNOWN
+        return stat_is_directory(M_fd, entry.name.data());
+    }
+  }
+
+  bool detail::dir_reader::exists(const fs::path& name) const {
+    struct stat st;
+    return M_fd >= 0 && ::fstatat(M_fd, name.c_str(), &st, 0) == 0;
+  }
+
+  bool detail::dir_reader::status(dir_status& st) const {
+    struct stat buf;
+    if (M_fd < 0 || ::fstat(M_fd, &buf) != 0) {
+      return false;
+    }
+
+#  ifdef __APPLE__
+    const struct timespec& mtime = buf.st_mtimespec;
+    const struct timespec& ctime = buf.st_ctimespec;
+#  else
+    const struct timespec& mtime = buf.st_mtim;
+    const struct timespec& ctime = buf.st_ctim;
+#  endif
+    st = {static_cast<std::uint64_t>(buf.st_dev),
+          static_cast<std::uint64_t>(buf.st_ino),
+          static_cast<std::uint64_t>(buf.st_nlink),
+          static_cast<std::int64_t>(mtime.tv_sec),
+          static_cast<std::int64_t>(mtime.tv_nsec),
+          static_cast<std::int64_t>(ctime.tv_sec),
+          static_cast<std::int64_t>(ctime.tv_nsec)};
+    return true;
+  }
+#endif
+
+#if defined(CPPGLOB_USE_GETDENTS)
+  namespace detail {
+    // record layout of getdents64(2)
+    struct linux_dirent64 {
+      std::uint64_t d_ino;
+      std::int64_t d_off;
+      unsigned short d_reclen;
+      unsigned char d_type;
+      char d_name[1];
+    };
+
+    constexpr std::size_t dirent_buffer_size = 32 * 1024;
+  }  // namespace detail
+
+  detail::dir_reader::dir_reader(std::pmr::memory_resource* resource) noexcept
+      : M_resource(resource) {}
+
+  detail::dir_reader::~dir_reader() {
+    close();
+    if (M_buffer != nullptr) {
+      M_resource->deallocate(M_buffer, dirent_buffer_size,
+                             alignof(linux_dirent64));
+    }
+  }
+
+  void detail::dir_reader::open(const fs::path& dirname) {
+    close();
+    const char* name = dirname.empty() ? "." : dirname.c_str();
+    M_fd = ::open(name, open_dir_flags);
+    allocate_buffer();
+  }
+
+  void detail::dir_reader::open_at(const dir_reader& parent,
+                                   const char* name) {
+    if (parent.M_fd >= 0) {
+      M_fd = ::openat(parent.M_fd, name, open_dir_flags);
+    }
+    allocate_buffer();
+  }
+
+  void detail::dir_reader::allocate_buffer() {
+    if (M_fd >= 0 && M_buffer == nullptr) {
+      try {
+        M_buffer = static_cast<char*>(M_resource->allocate(
+            dirent_buffer_size, alignof(linux_dirent64)));
+      } catch (...) {
+        close();
+        throw;
+      }
+    }
+  }
+
+  void detail::dir_reader::close() noexcept {
+    if (M_fd >= 0) {
+      ::close(M_fd);
+    }
+    M_fd = -1;
+    M_pos = M_end = 0L;
+  }
+
+  bool detail::dir_reader::next(dir_entry& entry) {
+    while (true) {
+      if (M_pos >= M_end) {
+        if (M_fd < 0) {
+          return false;
+        }
+
+        long nread =
+            ::syscall(SYS_getdents64, M_fd, M_buffer, dirent_buffer_size);
+        if (nread <= 0) {
+          return false;
+        }
+
+        M_pos = 0L;
+        M_end = static_cast<std::size_t>(nread);
+      }
+
+      const auto* d =
+          reinterpret_cast<const linux_dirent64*>(M_buffer + M_pos);
+      M_pos += d->d_reclen;
+
+      if (!is_dot_or_dotdot(d->d_name)) {
+        entry.name = string_view_type(d->d_name);
+        entry.type = to_entry_type(d->d_type);
+        return true;
+      }
+    }
+  }
+
+  void detail::dir_reader::rewind() {
+    if (M_fd >= 0) {
+      ::lseek(M_fd, 0, SEEK_SET);
+    }
+    M_pos = M_end = 0L;
+  }
+#elif defined(CPPGLOB_USE_FDOPENDIR)
+  detail::dir_reader::dir_reader(std::pmr::memory_resource*) noexcept {}
+
+  detail::dir_reader::~dir_reader() { close(); }
+
+  void detail::dir_reader::open(const fs::path& dirname) {
+    close();
+    const char* name = dirname.empty() ? "." : dirname.c_str();
+    M_dir = ::opendir(name);
+    if (M_dir != nullptr) {
+      M_fd = ::dirfd(M_dir);
+    }
+  }
+
+  void detail::dir_reader::open_at(const dir_reader& parent,
+                                   const char* name) {
+    if (parent.M_fd < 0) {
+      return;
+    }
+
+    int fd = ::openat(parent.M_fd, name, open_dir_flags);
+    if (fd < 0) {
+      return;
+    }
+
+    M_dir = ::fdopendir(fd);
+    if (M_dir == nullptr) {
+      ::close(fd);
+      return;
+    }
+    M_fd = fd;
+  }
+
+  void detail::dir_reader::close() noexcept {
+    if (M_dir != nullptr) {
+      ::closedir(M_dir);
+    }
+    M_dir = nullptr;
+    M_fd = -1;
+  }
+
+  bool detail::dir_reader::next(dir_entry& entry) {
+    if (M_dir == nullptr) {
+      return false;
+    }
+
+    while (const struct dirent* d = ::readdir(M_dir)) {
+      if (!is_dot_or_dotdot(d->d_name)) {
+        entry.name = string_view_type(d->d_name);
+#  ifdef DT_UNKNOWN
+        entry.type = to_entry_type(d->d_type);
+#  else
+        entry.type = entry_type::unknown;
+#  endif
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void detail::dir_reader::rewind() {
+    if (M_dir != nullptr) {
+      ::rewinddir(M_dir);
+    }
+  }
+#else
+  detail::dir_reader::dir_reader(std::pmr::memory_resource*) noexcept {}
+
+  detail::dir_reader::~dir_reader() = default;
+
+  void detail::dir_reader::open(const fs::path& dirname) {
+    M_dirname = dirname.empty() ? fs::path(CStr(".")) : dirname;
+    rewind();
+  }
+
+  void detail::dir_reader::open_at(const dir_reader& parent,
+                                   const char_type* name) {
+    M_dirname = parent.M_dirname / name;
+    rewind();
+  }
+
+  void detail::dir_reader::close() noexcept {
+    M_it = fs::directory_iterator();
+    M_open = false;
+    M_started = false;
+  }
+
+  bool detail::dir_reader::is_open() const noexcept { return M_open; }
+
+  bool detail::dir_reader::next(dir_entry& entry) {
+    std::error_code ec;
+    if (M_started) {
+      M_it.increment(ec);
+    }
+    M_started = true;
+
+    if (ec || M_it == fs::directory_iterator()) {
+      return false;
+    }
+
+    M_name = M_it->path().filename().native();
+    entry.name = M_name;
+    entry.type = entry_type::unknown;
+    return true;
+  }
+
+  void detail::dir_reader::rewind() {
+    std::error_code ec;
+    M_it = fs::directory_iterator(M_dirname, ec);
+    M_open = !ec;
+    M_started = false;
+  }
+
+  bool detail::dir_reader::is_directory(const dir_entry&) const {
+    std::error_code ec;
+    return M_it->is_directory(ec);
+  }
+
+  bool detail::dir_reader::exists(const fs::path& name) const {
+    std::error_code ec;
+    return fs::exists(M_dirname / name, ec);
+  }
+
+  bool detail::dir_reader::status(dir_status&) const { return false; }
+#endif
+}  // namespace cppglob
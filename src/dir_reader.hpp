@@ -0,0 +1,193 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_DIR_READER_HPP
+#define CPPGLOB_SRC_DIR_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <filesystem>
+#include <cppglob/config.hpp>
+
+#if defined(__linux__)
+#  define CPPGLOB_USE_GETDENTS 1
+#elif defined(__unix__) || defined(__APPLE__)
+#  define CPPGLOB_USE_FDOPENDIR 1
+#endif
+
+#ifdef CPPGLOB_USE_FDOPENDIR
+#  include <dirent.h>
+#endif
+
+namespace cppglob {
+  namespace detail {
+    enum class entry_type : unsigned char { unknown, directory, symlink, other };
+
+    /**
+     * @brief directory entry returned by dir_reader::next()
+     *
+     * The name refers to the internal buffer of the reader and is only valid
+     * until the next call of dir_reader::next().
+     */
+    struct CPPGLOB_LOCAL dir_entry {
+      string_view_type name;
+      entry_type type = entry_type::unknown;
+    };
+
+    /**
+     * @brief identity and change times of an open directory
+     *
+     * Adding, removing or renaming an entry updates the modification and
+     * change times of the directory (and the link count for
+     * subdirectories), so an unchanged status means unchanged entries.
+     */
+    struct CPPGLOB_LOCAL dir_status {
+      std::uint64_t device;
+      std::uint64_t inode;
+      std::uint64_t links;
+      std::int64_t mtime_sec;
+      std::int64_t mtime_nsec;
+      std::int64_t ctime_sec;
+      std::int64_t ctime_nsec;
+
+      bool operator==(const dir_status& other) const noexcept {
+        return device == other.device && inode == other.inode &&
+               links == other.links && mtime_sec == other.mtime_sec &&
+               mtime_nsec == other.mtime_nsec &&
+               ctime_sec == other.ctime_sec && ctime_nsec == other.ctime_nsec;
+      }
+    };
+
+    /**
+     * @brief reads the entries of a single directory
+     *
+     * On POSIX systems the reader owns a directory file descriptor and
+     * subdirectories are opened with openat(2) relative to it, so that the
+     * kernel resolves a single component per level instead of the whole
+     * path. On Linux the raw dirents are read with getdents64(2), elsewhere
+     * through fdopendir(3). In both cases d_type is used to classify entries
+     * and stat(2) is only needed for symbolic links and for file systems
+     * which report DT_UNKNOWN. Other platforms fall back to
+     * fs::directory_iterator. Entries "." and ".." are never returned and a
+     * directory which cannot be opened is read as empty. A reader can be
+     * opened again on another directory, keeping its dirent buffer, which
+     * is allocated from the memory resource of the reader.
+     */
+    class CPPGLOB_LOCAL dir_reader {
+     public:
+      /**
+       * @brief construct a closed reader
+       */
+      explicit dir_reader(std::pmr::memory_resource* resource =
+                              std::pmr::get_default_resource()) noexcept;
+
+      /**
+       * @param dirname directory to be read (current directory if empty)
+       */
+      explicit dir_reader(const fs::path& dirname);
+
+      /**
+       * @brief open the subdirectory most recently returned by parent.next()
+       */
+      dir_reader(const dir_reader& parent, const dir_entry& entry);
+
+      /**
+       * @brief open the subdirectory name of parent
+       */
+      dir_reader(const dir_reader& parent, const fs::path& name);
+
+      dir_reader(const dir_reader&) = delete;
+      dir_reader& operator=(const dir_reader&) = delete;
+
+      ~dir_reader();
+
+      /**
+       * @brief close the current directory and open another one, like the
+       * constructors
+       */
+      void open(const fs::path& dirname);
+      void open(const dir_reader& parent, const dir_entry& entry);
+      void open(const dir_reader& parent, const fs::path& name);
+
+      void close() noexcept;
+
+      bool is_open() const noexcept;
+
+      /**
+       * @brief read the next entry
+       * @return false when there are no more entries
+       */
+      bool next(dir_entry& entry);
+
+      /**
+       * @brief restart reading from the first entry
+       */
+      void rewind();
+
+      /**
+       * @brief test whether the entry most recently returned by next()
+       * refers to a directory, following symbolic links like
+       * fs::is_directory()
+       */
+      bool is_directory(const dir_entry& entry) const;
+
+      /**
+       * @brief test whether name exists in this directory, following
+       * symbolic links like fs::exists()
+       */
+      bool exists(const fs::path& name) const;
+
+      /**
+       * @brief get the status of the open directory with a single fstat(2)
+       * @return false if it is not available (e.g. on Windows)
+       */
+      bool status(dir_status& st) const;
+
+     private:
+      void open_at(const dir_reader& parent, const char_type* name);
+
+#if defined(CPPGLOB_USE_GETDENTS)
+      void allocate_buffer();
+#endif
+
+#if defined(CPPGLOB_USE_GETDENTS)
+      int M_fd = -1;
+      std::pmr::memory_resource* M_resource;
+      char* M_buffer = nullptr;
+      std::size_t M_pos = 0L;
+      std::size_t M_end = 0L;
+#elif defined(CPPGLOB_USE_FDOPENDIR)
+      DIR* M_dir = nullptr;
+      int M_fd = -1;
+#else
+      fs::path M_dirname;
+      fs::directory_iterator M_it;
+      bool M_open = false;
+      bool M_started = false;
+      string_type M_name;
+#endif
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,368 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "extglob.hpp"
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE bool is_group_operator(char_type c) {
+      return c == '?' || c == '*' || c == '+' || c == '@' || c == '!';
+    }
+
+    /**
+     * @brief find the parenthesis closing the group opened at open
+     * @return position of the closing parenthesis, or npos
+     */
+    CPPGLOB_INLINE std::size_t find_group_end(const string_view_type& pat,
+                                              std::size_t open) {
+      std::size_t depth = 0L;
+      std::size_t i = open;
+
+      while (i < pat.size()) {
+        const char_type c = pat[i];
+        if (c == '[') {
+          const std::size_t end = find_bracket_end(pat, i + 1);
+          if (end != string_view_type::npos) {
+            i = end + 1;
+            continue;
+          }
+        } else if (c == '(') {
+          ++depth;
+        } else if (c == ')' && --depth == 0) {
+          return i;
+        }
+        ++i;
+      }
+
+      return string_view_type::npos;
+    }
+  }  // namespace detail
+
+  bool detail::has_extglob(const string_view_type& pattern) {
+    for (std::size_t i = 0; i + 1 < pattern.size(); ++i) {
+      if (is_group_operator(pattern[i]) && pattern[i + 1] == '(' &&
+          find_group_end(pattern, i + 1) != string_view_type::npos) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  detail::extglob_dfa::extglob_dfa(const string_view_type& pattern,
+                                   bool icase, std::size_t max_nodes)
+      : M_icase(icase), M_max_nodes(max_nodes) {
+    make(M_initial, {expr::nothing, false});
+    make(M_initial, {expr::empty, true});
+    make(M_initial, {expr::negation, true, nothing_id});
+
+    std::size_t i = 0L;
+    M_start = parse(M_initial, pattern, i, false);
+
+    // narrow characters accepted by the same tokens share a class
+    using uchar = std::make_unsigned_t<char_type>;
+    std::map<std::string, unsigned char> signatures;
+    for (unsigned int u = 0; u < 256; ++u) {
+      const auto c = static_cast<char_type>(static_cast<uchar>(u));
+      std::string signature(M_tokens.size(), '0');
+      for (std::size_t k = 0; k < M_tokens.size(); ++k) {
+        if (token_matches(k, c)) {
+          signature[k] = '1';
+        }
+      }
+      const auto id = static_cast<unsigned char>(signatures.size());
+      const auto it = signatures.emplace(std::move(signature), id).first;
+      M_class_of[u] = it->second;
+    }
+    M_num_classes = signatures.size();
+
+    M_initial.table.assign(M_initial.nodes.size() * M_num_classes, unknown);
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::make(arena& a,
+                                                         expr e) const {
+    std::vector<id_type> key{e.kind, e.left, e.right,
+                             static_cast<id_type>(e.index)};
+    key.insert(key.end(), e.items.begin(), e.items.end());
+
+    const auto it = a.index.find(key);
+    if (it != a.index.end()) {
+      return it->second;
+    }
+
+    const auto id = static_cast<id_type>(a.nodes.size());
+    a.nodes.push_back(std::move(e));
+    a.table.resize(a.nodes.size() * M_num_classes, unknown);
+    a.index.emplace(std::move(key), id);
+    return id;
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::concat(
+      arena& a, id_type lhs, id_type rhs) const {
+    if (lhs == nothing_id || rhs == nothing_id) {
+      return nothing_id;
+    }
+    if (lhs == empty_id) {
+      return rhs;
+    }
+    if (rhs == empty_id) {
+      return lhs;
+    }
+
+    // concatenations are kept right-nested
+    const expr& l = a.nodes[lhs];
+    if (l.kind == expr::concat) {
+      const id_type first = l.left;
+      return concat(a, first, concat(a, l.right, rhs));
+    }
+
+    const bool nullable = l.nullable && a.nodes[rhs].nullable;
+    return make(a, {expr::concat, nullable, lhs, rhs});
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::alternation(
+      arena& a, std::vector<id_type> items) const {
+    // flattened, sorted and without duplicates, so that equivalent
+    // alternations are the same expression
+    std::vector<id_type> flat;
+    for (const id_type item : items) {
+      const expr& e = a.nodes[item];
+      if (item == universal_id) {
+        return universal_id;
+      }
+      if (e.kind == expr::alternation) {
+        flat.insert(flat.end(), e.items.begin(), e.items.end());
+      } else if (item != nothing_id) {
+        flat.push_back(item);
+      }
+    }
+
+    std::sort(flat.begin(), flat.end());
+    flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+    if (flat.empty()) {
+      return nothing_id;
+    }
+    if (flat.size() == 1) {
+      return flat[0];
+    }
+
+    bool nullable = false;
+    for (const id_type item : flat) {
+      nullable = nullable || a.nodes[item].nullable;
+    }
+
+    expr e{expr::alternation, nullable};
+    e.items = std::move(flat);
+    return make(a, std::move(e));
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::star(
+      arena& a, id_type operand) const {
+    if (operand == nothing_id || operand == empty_id) {
+      return empty_id;
+    }
+    if (a.nodes[operand].kind == expr::star) {
+      return operand;
+    }
+    return make(a, {expr::star, true, operand});
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::negation(
+      arena& a, id_type operand) const {
+    const expr& e = a.nodes[operand];
+    if (e.kind == expr::negation) {
+      return e.left;
+    }
+    return make(a, {expr::negation, !e.nullable, operand});
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::add_token(
+      arena& a, pattern_token tok) {
+    M_tokens.push_back(tok);
+    expr e{expr::token, false};
+    e.index = M_tokens.size() - 1;
+    return make(a, std::move(e));
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::parse(
+      arena& a, const string_view_type& pattern, std::size_t& i,
+      bool in_group) {
+    std::vector<id_type> sequence;
+
+    while (i < pattern.size()) {
+      const char_type c = pattern[i];
+      if (in_group && (c == '|' || c == ')')) {
+        break;
+      }
+      ++i;
+
+      if (is_group_operator(c) && i < pattern.size() && pattern[i] == '(' &&
+          find_group_end(pattern, i) != string_view_type::npos) {
+        std::vector<id_type> alternatives;
+        while (true) {
+          ++i;  // '(' or '|'
+          alternatives.push_back(parse(a, pattern, i, true));
+          if (i >= pattern.size() || pattern[i] == ')') {
+            ++i;
+            break;
+          }
+        }
+
+        const id_type group = alternation(a, std::move(alternatives));
+        switch (c) {
+          case '?':
+            sequence.push_back(alternation(a, {empty_id, group}));
+            break;
+          case '*':
+            sequence.push_back(star(a, group));
+            break;
+          case '+':
+            sequence.push_back(concat(a, group, star(a, group)));
+            break;
+          case '@':
+            sequence.push_back(group);
+            break;
+          default:
+            sequence.push_back(negation(a, group));
+            break;
+        }
+        continue;
+      }
+
+      if (c == '*') {
+        sequence.push_back(star(a, add_token(a, {pattern_token::any, c, 0L})));
+      } else if (c == '?') {
+        sequence.push_back(add_token(a, {pattern_token::any, c, 0L}));
+      } else if (c == '[') {
+        const std::size_t end = find_bracket_end(pattern, i);
+        if (end == string_view_type::npos) {
+          sequence.push_back(add_token(a, {pattern_token::literal, c, 0L}));
+        } else {
+          M_classes.push_back(
+              parse_class(pattern.substr(i, end - i), M_icase));
+          sequence.push_back(add_token(
+              a, {pattern_token::bracket, c, M_classes.size() - 1}));
+          i = end + 1;
+        }
+      } else {
+        sequence.push_back(add_token(a, literal_token(c, M_icase, M_classes)));
+      }
+    }
+
+    id_type result = empty_id;
+    for (auto it = sequence.rbegin(); it != sequence.rend(); ++it) {
+      result = concat(a, *it, result);
+    }
+    return result;
+  }
+
+  bool detail::extglob_dfa::token_matches(std::size_t i, char_type c) const {
+    const pattern_token& tok = M_tokens[i];
+    switch (tok.kind) {
+      case pattern_token::literal:
+        return tok.ch == c;
+      case pattern_token::bracket:
+        return M_classes[tok.index].contains(c);
+      default:
+        return true;
+    }
+  }
+
+  detail::extglob_dfa::id_type detail::extglob_dfa::derive(
+      arena& a, id_type id, char_type c, std::size_t cls) const {
+    const std::size_t slot = id * M_num_classes + cls;
+    if (cls < M_num_classes && a.table[slot] != unknown) {
+      return a.table[slot];
+    }
+
+    // the node is copied since new expressions may move it
+    const expr e = a.nodes[id];
+    id_type result = nothing_id;
+
+    switch (e.kind) {
+      case expr::token:
+        result = token_matches(e.index, c) ? empty_id : nothing_id;
+        break;
+      case expr::concat: {
+        const id_type head = concat(a, derive(a, e.left, c, cls), e.right);
+        result = a.nodes[e.left].nullable
+                     ? alternation(a, {head, derive(a, e.right, c, cls)})
+                     : head;
+        break;
+      }
+      case expr::alternation: {
+        std::vector<id_type> items;
+        for (const id_type item : e.items) {
+          items.push_back(derive(a, item, c, cls));
+        }
+        result = alternation(a, std::move(items));
+        break;
+      }
+      case expr::star:
+        result = concat(a, derive(a, e.left, c, cls), id);
+        break;
+      case expr::negation:
+        result = negation(a, derive(a, e.left, c, cls));
+        break;
+      default:
+        break;
+    }
+
+    if (cls < M_num_classes) {
+      a.table[slot] = result;
+    }
+    return result;
+  }
+
+  bool detail::extglob_dfa::run(arena& a,
+                                const string_view_type& name) const {
+    using uchar = std::make_unsigned_t<char_type>;
+    id_type state = M_start;
+
+    for (const char_type c : name) {
+      const std::size_t cls = is_narrow(c)
+                                  ? M_class_of[static_cast<uchar>(c)]
+                                  : M_num_classes;
+      state = derive(a, state, c, cls);
+      if (state == nothing_id || state == universal_id) {
+        break;
+      }
+    }
+
+    return a.nodes[state].nullable;
+  }
+
+  bool detail::extglob_dfa::match(const string_view_type& name) const {
+    arena& a = M_caches.get(M_initial);
+    if (a.nodes.size() > M_max_nodes) {
+      a = M_initial;
+    }
+    return run(a, name);
+  }
+}  // namespace cppglob
@@ -0,0 +1,148 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_EXTGLOB_HPP
+#define CPPGLOB_SRC_EXTGLOB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "matcher.hpp"
+#include "thread_cache.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief test whether pattern contains an extended glob group, i.e. one
+     * of '?', '*', '+', '@' or '!' followed by a closed parenthesis
+     */
+    CPPGLOB_LOCAL bool has_extglob(const string_view_type& pattern);
+
+    /**
+     * @brief DFA built on demand from the derivatives of an extended pattern
+     *
+     * The pattern, ksh extended groups ?(..), *(..), +(..), @(..) and !(..)
+     * mixed with plain wildcards, is parsed into a regular expression with
+     * complement. A state is an expression, normalized so that equivalent
+     * alternations are the same state, and the transition on a character is
+     * its Brzozowski derivative: the derivative of a negated group is the
+     * negation of the derivative, so negation never backtracks. States and
+     * transitions are created only when a name reaches them, and characters
+     * are grouped into classes which no token can tell apart. Matching is
+     * linear in the length of the name. Every thread derives into its own
+     * copy of the initial expressions (see thread_cache), which is reset
+     * before a name once it holds more than max_nodes expressions.
+     */
+    class CPPGLOB_LOCAL extglob_dfa {
+     public:
+      /**
+       * @param icase letters match all their case variants (the pattern is
+       * already folded)
+       */
+      extglob_dfa(const string_view_type& pattern, bool icase,
+                  std::size_t max_nodes = 4096L);
+
+      bool match(const string_view_type& name) const;
+
+     private:
+      using id_type = std::uint32_t;
+
+      static constexpr id_type unknown = ~id_type(0);
+
+      struct expr {
+        enum kind_type : unsigned char {
+          nothing,  // matches no name
+          empty,    // matches the empty name
+          token,
+          concat,
+          alternation,
+          star,
+          negation
+        };
+
+        expr(kind_type k, bool n, id_type l = 0, id_type r = 0)
+            : kind(k), nullable(n), left(l), right(r) {}
+
+        kind_type kind;
+        bool nullable;           // matches the empty name
+        id_type left = 0;        // concat, star and negation
+        id_type right = 0;       // concat
+        std::size_t index = 0L;  // index into M_tokens (token)
+        std::vector<id_type> items;  // sorted operands (alternation)
+      };
+
+      /**
+       * @brief interned expressions and their derivatives by narrow
+       * character class
+       */
+      struct arena {
+        std::vector<expr> nodes;
+        std::map<std::vector<id_type>, id_type> index;
+        std::vector<id_type> table;
+      };
+
+      // expressions which exist in every arena
+      static constexpr id_type nothing_id = 0;
+      static constexpr id_type empty_id = 1;
+      static constexpr id_type universal_id = 2;  // !(nothing)
+
+      id_type make(arena& a, expr e) const;
+      id_type concat(arena& a, id_type lhs, id_type rhs) const;
+      id_type alternation(arena& a, std::vector<id_type> items) const;
+      id_type star(arena& a, id_type operand) const;
+      id_type negation(arena& a, id_type operand) const;
+
+      id_type parse(arena& a, const string_view_type& pattern,
+                    std::size_t& i, bool in_group);
+
+      id_type add_token(arena& a, pattern_token tok);
+
+      bool token_matches(std::size_t i, char_type c) const;
+
+      /**
+       * @param cls class of c, or M_num_classes for wide characters whose
+       * derivatives are not cached
+       */
+      id_type derive(arena& a, id_type id, char_type c,
+                     std::size_t cls) const;
+
+      bool run(arena& a, const string_view_type& name) const;
+
+      bool M_icase;
+      std::vector<pattern_token> M_tokens;
+      std::vector<char_class> M_classes;
+
+      unsigned char M_class_of[256];  // character class of narrow characters
+      std::size_t M_num_classes = 0L;
+      std::size_t M_max_nodes;
+
+      arena M_initial;
+      id_type M_start;
+
+      // states reached so far by each thread
+      thread_cache<arena> M_caches;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -23,18 +23,13 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
-#include <regex>
+#include <algorithm>
 #include <filesystem>
 #include <cppglob/fnmatch.hpp>
+#include "matcher.hpp"
 
 namespace cppglob {
-  using regex_type = std::basic_regex<char_type>;
-
   namespace detail {
-    CPPGLOB_INLINE regex_type compile_pattern(const string_view_type& pat) {
-      return regex_type(translate(pat));
-    }
-
     CPPGLOB_INLINE string_type replace_all(const string_view_type& str,
                                            const string_view_type& from,
                                            const string_view_type& to) {
@@ -77,10 +72,27 @@ namespace cppglob {
 
   void filter(std::vector<fs::path>& names, const string_view_type& pat) {
     string_type pat_str = detail::normpath(pat);
-    regex_type re =
-        detail::compile_pattern(string_view_type(&pat_str[0], pat_str.size()));
+    const detail::matcher m(string_view_type(pat_str.data(), pat_str.size()));
+    auto filter_fn = [&](std::vector<fs::path>::value_type& p) -> bool {
+      return !m.match_path(p);
+    };
+
+    auto result = std::remove_if(names.begin(), names.end(), filter_fn);
+    names.erase(result, names.end());
+  }
+
+  void filter(std::vector<fs::path>& names, const pattern& pat) {
+    auto filter_fn = [&](std::vector<fs::path>::value_type& p) -> bool {
+      return !pat.match(p);
+    };
+
+    auto result = std::remove_if(names.begin(), names.end(), filter_fn);
+    names.erase(result, names.end());
+  }
+
+  void filter(std::vector<fs::path>& names, const pattern_set& pats) {
     auto filter_fn = [&](std::vector<fs::path>::value_type& p) -> bool {
-      return !std::regex_match(p.lexically_normal().native(), re);
+      return !pats.match_any(p);
     };
 
     auto result = std::remove_if(names.begin(), names.end(), filter_fn);
@@ -23,179 +23,20 @@
 #include <cassert>
 #include <cstdlib>
 #include <algorithm>
+#include <iterator>
+#include <memory_resource>
+#include <system_error>
+#include <thread>
 #include <filesystem>
 #include <cppglob/fnmatch.hpp>
 #include <cppglob/glob.hpp>
 #include <cppglob/iglob.hpp>
+#include "glob_walker.hpp"
+#include "parallel_walker.hpp"
+#include "pattern_impl.hpp"
 
 namespace cppglob {
   namespace detail {
-    CPPGLOB_INLINE bool has_magic(const string_type& str) {
-      static const string_view_type magics = CStr("*?[");
-      for (const char& c : str) {
-        for (const char& magic : magics) {
-          if (c == magic) {
-            return true;
-          }
-        }
-      }
-
-      return false;
-    }
-
-    CPPGLOB_INLINE bool ishidden(const fs::path& pathname) {
-      return pathname.native()[0] == '.';
-    }
-
-    CPPGLOB_INLINE bool isrecursive(const fs::path& pathname) {
-      return pathname.native() == CStr("**");
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> iterdir(const fs::path& dirname,
-                                                 bool dironly) {
-      fs::path base_dir = (dirname.empty()) ? fs::current_path() : dirname;
-
-      if (!fs::is_directory(base_dir)) {
-        return std::vector<fs::path>();
-      }
-
-      fs::directory_iterator files(base_dir);
-
-      std::vector<fs::path> ret;
-
-      for (auto&& file : files) {
-        if (!dironly || fs::is_directory(file)) {
-          ret.push_back(file.path().filename());
-        }
-      }
-      return ret;
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> rlistdir(const fs::path& dirname,
-                                                  bool dironly) {
-      std::vector<fs::path> ret;
-
-      for (auto&& x : iterdir(dirname, dironly)) {
-        if (!ishidden(x)) {
-          ret.push_back(x);
-          fs::path path = (dirname.empty()) ? x : (dirname / x);
-
-          if (fs::is_directory(path)) {
-            for (auto&& y : rlistdir(path, dironly)) {
-              ret.push_back(x / y);
-            }
-          }
-        }
-      }
-
-      return ret;
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> glob0(const fs::path& dirname,
-                                               const fs::path& basename,
-                                               bool dironly) {
-      if (basename.empty()) {
-        if (fs::is_directory(dirname)) {
-          return std::vector<fs::path>({basename});
-        }
-      } else if (fs::exists(dirname / basename)) {
-        return std::vector<fs::path>({basename});
-      }
-
-      return std::vector<fs::path>();
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> glob1(const fs::path& dirname,
-                                               const fs::path& pattern,
-                                               bool dironly) {
-      std::vector<fs::path> names = iterdir(dirname, dironly);
-
-      if (ishidden(pattern)) {
-        auto result =
-            std::remove_if(names.begin(), names.end(),
-                           [](fs::path& p) -> bool { return ishidden(p); });
-        names.erase(result, names.end());
-      }
-
-      const string_type& pattern_str = pattern.native();
-      ::cppglob::filter(names,
-                        string_view_type(&pattern_str[0], pattern_str.size()));
-      return names;
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> glob2(const fs::path& dirname,
-                                               const fs::path& pattern,
-                                               bool dironly) {
-      assert(isrecursive(pattern));
-      std::vector<fs::path> result = rlistdir(dirname, dironly);
-
-      if (result.empty()) {
-        result.emplace_back("");
-      } else {
-        result.push_back(std::move(result.front()));
-        result[0] = fs::path("");
-      }
-
-      return result;
-    }
-
-    CPPGLOB_INLINE std::vector<fs::path> iglob(const fs::path& pathname,
-                                               bool recursive, bool dironly) {
-      fs::path dirname = pathname.parent_path();
-      fs::path basename = pathname.filename();
-
-      if (!has_magic(pathname)) {
-        assert(!dironly);
-        if (!basename.empty()) {
-          if (fs::exists(pathname)) {
-            return std::vector<fs::path>({pathname});
-          }
-        } else {
-          if (fs::is_directory(dirname)) {
-            return std::vector<fs::path>({pathname});
-          }
-        }
-
-        return std::vector<fs::path>();
-      }
-
-      if (dirname.empty()) {
-        if (recursive && isrecursive(basename)) {
-          return glob2(dirname, basename, dironly);
-        } else {
-          return glob1(dirname, basename, dironly);
-        }
-      }
-
-      std::vector<fs::path> dirs;
-      if (dirname != pathname && has_magic(dirname)) {
-        dirs = iglob(dirname, recursive, true);
-      } else {
-        dirs.push_back(dirname);
-      }
-
-      std::vector<fs::path> (*glob_in_dir)(const fs::path&, const fs::path&,
-                                           bool);
-      if (has_magic(basename)) {
-        if (recursive && isrecursive(basename)) {
-          glob_in_dir = glob2;
-        } else {
-          glob_in_dir = glob1;
-        }
-      } else {
-        glob_in_dir = glob0;
-      }
-
-      std::vector<fs::path> files;
-      for (auto&& dirname : dirs) {
-        for (auto&& name : glob_in_dir(dirname, basename, dironly)) {
-          files.emplace_back(dirname / name);
-        }
-      }
-
-      return files;
-    }
-
 #ifdef CPPGLOB_IS_WINDOWS
     CPPGLOB_INLINE string_view_type drive_name(const fs::path& pathname) {
       const string_type& path_str = pathname.native();
@@ -250,30 +91,190 @@ namespace cppglob {
     }
   }  // namespace detail
 
-  std::vector<fs::path> glob(const fs::path& pathname, bool recursive) {
-    std::vector<fs::path> files = detail::iglob(pathname, recursive, false);
-    if (recursive && detail::isrecursive(pathname)) {
-      assert(files.size() > 0L);
+  namespace detail {
+    CPPGLOB_INLINE void remove_recursive_root(const compiled_pattern& compiled,
+                                              std::vector<fs::path>& files) {
+      if (compiled.recursive && isrecursive(compiled.pathname)) {
+        // the directory itself is the only empty result, found first
+        // unless the threads of an unordered walk return it later
+        const auto root = std::find(files.begin(), files.end(), fs::path());
+        assert(root != files.end());
+        files.erase(root);
+      }
+    }
+  }  // namespace detail
+
+  std::vector<fs::path> glob(const pattern& pat) {
+    const detail::compiled_pattern& compiled = detail::pattern_access::get(pat);
+    detail::glob_walker walker(detail::pattern_access::share(pat));
 
-      // remove first value
-      files[0] = std::move(files.back());
-      files.pop_back();
+    std::vector<fs::path> files;
+    while (walker.advance()) {
+      files.emplace_back(walker.result());
     }
 
+    detail::remove_recursive_root(compiled, files);
     return files;
   }
 
-  glob_iterator iglob(const fs::path& pathname, bool recursive) {
-    std::vector<fs::path> files = detail::iglob(pathname, recursive, false);
-    glob_iterator it(std::move(files));
+  path_list& glob(const pattern& pat, path_list& results) {
+    return glob(pat, results, std::pmr::get_default_resource());
+  }
+
+  path_list& glob(const pattern& pat, path_list& results,
+                  std::pmr::memory_resource* resource) {
+    const detail::compiled_pattern& compiled = detail::pattern_access::get(pat);
+    detail::glob_walker walker(detail::pattern_access::share(pat), resource);
+
+    // the directory itself yielded first by a top-level '**'
+    if (compiled.recursive && detail::isrecursive(compiled.pathname)) {
+      walker.advance();
+    }
 
-    if (recursive && detail::isrecursive(pathname)) {
+    while (walker.advance()) {
+      results.push_back(walker.result());
+    }
+    return results;
+  }
+
+  path_list glob(const pattern& pat, std::pmr::memory_resource* resource) {
+    path_list results(resource);
+    glob(pat, results, resource);
+    return results;
+  }
+
+  std::vector<fs::path> glob(const pattern& pat, const glob_options& options) {
+    const detail::compiled_pattern& compiled = detail::pattern_access::get(pat);
+    unsigned int threads = options.threads;
+    if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+    }
+
+    // the groups of a brace pattern are walked sequentially
+    if (threads <= 1 || !compiled.magic || !compiled.groups.empty()) {
+      return glob(pat);
+    }
+
+    detail::parallel_walker walker(compiled, threads, options.ordered);
+    std::vector<fs::path> files = walker.run();
+
+    detail::remove_recursive_root(compiled, files);
+    return files;
+  }
+
+  namespace detail {
+    /**
+     * @brief patterns which are walked together from the same root
+     */
+    struct CPPGLOB_LOCAL walk_group {
+      fs::path root;
+      std::vector<std::vector<pattern_segment>> segments;
+      std::vector<std::size_t> ids;
+    };
+
+    /**
+     * @brief split the root of a relative pattern into literal segments
+     *
+     * This lets a pattern rooted at "src" share the walk from the current
+     * directory with the patterns rooted there. The root is only split if
+     * joining the segments again gives the same string (no redundant
+     * separators) and if it is a directory, since '**' yields a root which
+     * does not exist.
+     */
+    CPPGLOB_INLINE bool split_root(const fs::path& root,
+                                   std::vector<pattern_segment>& segments) {
+      if (root.empty() || root.has_root_path()) {
+        return false;
+      }
+
+      string_type joined;
+      for (const fs::path& name : root) {
+        if (name.empty()) {
+          return false;
+        }
+        append_name(joined, name.native());
+        segments.push_back({pattern_segment::literal, name, false, matcher()});
+      }
+
+      std::error_code ec;
+      return joined == root.native() && fs::is_directory(root, ec);
+    }
+  }  // namespace detail
+
+  std::vector<std::vector<fs::path>> glob(
+      const std::vector<pattern>& patterns) {
+    std::vector<std::vector<fs::path>> results(patterns.size());
+    std::vector<detail::walk_group> groups;
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      const detail::compiled_pattern& compiled =
+          detail::pattern_access::get(patterns[i]);
+      if (!compiled.magic || !compiled.groups.empty()) {
+        results[i] = glob(patterns[i]);
+        continue;
+      }
+
+      std::vector<detail::pattern_segment> segments;
+      fs::path root;
+      if (!detail::split_root(compiled.root, segments)) {
+        segments.clear();
+        root = compiled.root;
+      }
+      segments.insert(segments.end(), compiled.segments.begin(),
+                      compiled.segments.end());
+
+      auto group = std::find_if(
+          groups.begin(), groups.end(),
+          [&root](const detail::walk_group& g) { return g.root == root; });
+      if (group == groups.end()) {
+        groups.push_back({root, {}, {}});
+        group = std::prev(groups.end());
+      }
+      group->segments.push_back(std::move(segments));
+      group->ids.push_back(i);
+    }
+
+    for (const detail::walk_group& group : groups) {
+      std::vector<const std::vector<detail::pattern_segment>*> segments;
+      for (const auto& s : group.segments) {
+        segments.push_back(&s);
+      }
+
+      detail::glob_walker walker(group.root, std::move(segments));
+      while (walker.advance()) {
+        results[group.ids[walker.result_pattern()]].emplace_back(
+            walker.result());
+      }
+    }
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      detail::remove_recursive_root(detail::pattern_access::get(patterns[i]),
+                                    results[i]);
+    }
+
+    return results;
+  }
+
+  std::vector<fs::path> glob(const fs::path& pathname, bool recursive) {
+    return glob(pattern(pathname, recursive));
+  }
+
+  glob_iterator iglob(const pattern& pat) {
+    const detail::compiled_pattern& compiled = detail::pattern_access::get(pat);
+    glob_iterator it(std::make_shared<detail::glob_walker>(
+        detail::pattern_access::share(pat)));
+
+    if (compiled.recursive && detail::isrecursive(compiled.pathname)) {
       ++it;
     }
 
     return it;
   }
 
+  glob_iterator iglob(const fs::path& pathname, bool recursive) {
+    return iglob(pattern(pathname, recursive));
+  }
+
   glob_iterator iglob() { return glob_iterator(); }
 
   fs::path escape(const fs::path& pathname) {
@@ -0,0 +1,135 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <filesystem>
+#include <cppglob/glob_context.hpp>
+#include "glob_walker.hpp"
+#include "listing_cache.hpp"
+#include "pattern_impl.hpp"
+
+namespace cppglob {
+  namespace detail {
+    struct CPPGLOB_LOCAL glob_context_impl {
+      struct cache_entry {
+        std::size_t hash;
+        bool recursive;
+        pattern_flags flags;
+        pattern pat;
+        std::uint64_t last_use;
+      };
+
+      explicit glob_context_impl(std::size_t size) : cache_size(size) {
+        cache.reserve(cache_size);
+      }
+
+      std::size_t cache_size;
+      std::vector<cache_entry> cache;
+      std::uint64_t clock = 0L;
+
+      // declared before the walker, whose frames may read a listing
+      std::unique_ptr<listing_cache> listings;
+      glob_walker walker;
+      path_list results;
+    };
+  }  // namespace detail
+
+  glob_context::glob_context(std::size_t cache_size)
+      : M_impl(std::make_unique<detail::glob_context_impl>(cache_size)) {}
+
+  glob_context::glob_context(glob_context&& other) noexcept = default;
+  glob_context& glob_context::operator=(glob_context&& other) noexcept =
+      default;
+  glob_context::~glob_context() = default;
+
+  pattern glob_context::compile(const fs::path& pathname, bool recursive,
+                                pattern_flags flags) {
+    detail::glob_context_impl& impl = *M_impl;
+    const std::size_t hash = std::hash<string_type>()(pathname.native());
+
+    // the cache is small, so a linear scan over the hashes is enough
+    detail::glob_context_impl::cache_entry* victim = nullptr;
+    for (auto& entry : impl.cache) {
+      if (entry.hash == hash && entry.recursive == recursive &&
+          entry.flags == flags &&
+          entry.pat.path().native() == pathname.native()) {
+        entry.last_use = ++impl.clock;
+        return entry.pat;
+      }
+      if (victim == nullptr || entry.last_use < victim->last_use) {
+        victim = &entry;
+      }
+    }
+
+    pattern pat(pathname, recursive, flags);
+    if (impl.cache.size() < impl.cache_size) {
+      impl.cache.push_back({hash, recursive, flags, pat, ++impl.clock});
+    } else if (victim != nullptr) {
+      *victim = {hash, recursive, flags, pat, ++impl.clock};
+    }
+    return pat;
+  }
+
+  const path_list& glob_context::glob(const pattern& pat) {
+    M_impl->results.clear();
+    return glob(pat, M_impl->results);
+  }
+
+  const path_list& glob_context::glob(const fs::path& pathname, bool recursive,
+                                      pattern_flags flags) {
+    return glob(compile(pathname, recursive, flags));
+  }
+
+  path_list& glob_context::glob(const pattern& pat, path_list& results) {
+    const detail::compiled_pattern& compiled = detail::pattern_access::get(pat);
+    detail::glob_walker& walker = M_impl->walker;
+    walker.reset(detail::pattern_access::share(pat));
+
+    // the directory itself yielded first by a top-level '**'
+    if (compiled.recursive && detail::isrecursive(compiled.pathname)) {
+      walker.advance();
+    }
+
+    while (walker.advance()) {
+      results.push_back(walker.result());
+    }
+    return results;
+  }
+
+  void glob_context::clear_cache() noexcept { M_impl->cache.clear(); }
+
+  void glob_context::cache_listings(std::size_t max_entries) {
+    detail::glob_context_impl& impl = *M_impl;
+    impl.walker.use_listing_cache(nullptr);
+    impl.listings.reset();
+
+    if (max_entries != 0) {
+      impl.listings = std::make_unique<detail::listing_cache>(max_entries);
+      impl.walker.use_listing_cache(impl.listings.get());
+    }
+  }
+}  // namespace cppglob
@@ -0,0 +1,449 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <filesystem>
+#include "glob_walker.hpp"
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE bool is_dot_name(const fs::path& name) {
+      const string_type& str = name.native();
+      return str == CStr(".") || str == CStr("..");
+    }
+  }  // namespace detail
+
+  detail::state_list detail::walk_rules::initial_states() const {
+    state_list states;
+    initial_states(states);
+    return states;
+  }
+
+  void detail::walk_rules::initial_states(state_list& states) const {
+    states.clear();
+    for (std::size_t i = 0; i < M_patterns.size(); ++i) {
+      add_state(states, {i, 0L, true});
+    }
+  }
+
+  void detail::walk_rules::add_state(state_list& states,
+                                     walk_state state) const {
+    while (true) {
+      bool added = true;
+      for (walk_state& s : states) {
+        if (s.pattern == state.pattern && s.index == state.index) {
+          // reached through the self-loop of '**' by another way
+          s.fresh = s.fresh && state.fresh;
+          added = false;
+          break;
+        }
+      }
+
+      // '**' also matches zero directories
+      if (!added || segment(state).kind != pattern_segment::recursive ||
+          is_last(state)) {
+        if (added) {
+          states.push_back(state);
+        }
+        return;
+      }
+
+      states.push_back(state);
+      state = {state.pattern, state.index + 1, true};
+    }
+  }
+
+  bool detail::walk_rules::matches_self(const walk_state& state, bool empty,
+                                        bool is_open) const {
+    const pattern_segment& seg = segment(state);
+
+    if (seg.kind == pattern_segment::literal && seg.name.empty()) {
+      // trailing separator
+      return !empty && is_open;
+    }
+
+    // '**' matching zero directories, with a trailing separator
+    return seg.kind == pattern_segment::recursive && state.fresh &&
+           is_last(state);
+  }
+
+  bool detail::walk_rules::needs_listing(const state_list& states) const {
+    for (const walk_state& s : states) {
+      if (segment(s).kind != pattern_segment::literal) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const fs::path* detail::walk_rules::probe_name(const walk_state& state,
+                                                 bool listing) const {
+    // literal segments are looked up without reading the directory unless
+    // the directory has to be read anyway. "." and ".." never appear in a
+    // listing.
+    const pattern_segment& seg = segment(state);
+    if (seg.kind != pattern_segment::literal || seg.name.empty() ||
+        (listing && !is_dot_name(seg.name))) {
+      return nullptr;
+    }
+    return &seg.name;
+  }
+
+  void detail::walk_rules::match_entry(const state_list& states,
+                                       const string_view_type& name,
+                                       state_list& next,
+                                       index_list& matched) const {
+    const bool hidden = name[0] == '.';
+    next.clear();
+    matched.clear();
+
+    for (const walk_state& s : states) {
+      const pattern_segment& seg = segment(s);
+      const bool last = is_last(s);
+
+      switch (seg.kind) {
+        case pattern_segment::literal:
+          if (seg.name.empty() || is_dot_name(seg.name) ||
+              (seg.icase ? !seg.match.match(name)
+                         : name != seg.name.native())) {
+            continue;
+          }
+          break;
+        case pattern_segment::magic:
+          if ((seg.hidden && hidden) || !seg.match.match(name)) {
+            continue;
+          }
+          break;
+        default:
+          // '**' consumes the entry and stays active below it
+          if (hidden) {
+            continue;
+          }
+          add_state(next, {s.pattern, s.index, false});
+          break;
+      }
+
+      if (!last) {
+        if (seg.kind != pattern_segment::recursive) {
+          add_state(next, {s.pattern, s.index + 1, true});
+        }
+      } else if (std::find(matched.begin(), matched.end(), s.pattern) ==
+                 matched.end()) {
+        matched.push_back(s.pattern);
+      }
+    }
+  }
+
+  detail::glob_walker::glob_walker(std::pmr::memory_resource* resource)
+      : M_rules(resource),
+        M_stack(resource),
+        M_next(resource),
+        M_matched(resource),
+        M_path(resource) {}
+
+  detail::glob_walker::glob_walker(std::shared_ptr<const compiled_pattern> pat,
+                                   std::pmr::memory_resource* resource)
+      : glob_walker(resource) {
+    reset(std::move(pat));
+  }
+
+  detail::glob_walker::glob_walker(
+      const fs::path& root,
+      const std::vector<const std::vector<pattern_segment>*>& patterns)
+      : M_root(&root), M_rules(patterns) {}
+
+  void detail::glob_walker::reset(std::shared_ptr<const compiled_pattern> pat) {
+    while (M_depth > 0) {
+      pop();
+    }
+
+    M_pattern = std::move(pat);
+    M_root = &M_pattern->root;
+    M_rules.clear();
+    M_rules.add_pattern(M_pattern->segments);
+    M_matched.clear();
+    M_matched_pos = 0L;
+    M_result_length = 0L;
+    M_result_pattern = 0L;
+    M_group = 0L;
+    M_unique = false;
+    M_started = false;
+  }
+
+  detail::glob_walker::frame& detail::glob_walker::spare_frame() {
+    if (M_depth == M_stack.size()) {
+      M_stack.emplace_back(M_stack.get_allocator().resource());
+    }
+    return M_stack[M_depth];
+  }
+
+  void detail::glob_walker::push_root(const fs::path& root) {
+    frame& f = spare_frame();
+    f.dir.open(root);
+    M_path.assign(root.native());
+    f.length = M_path.size();
+    M_rules.initial_states(f.states);
+    f.state = start;
+    f.pos = 0L;
+    ++M_depth;
+  }
+
+  void detail::glob_walker::extend_path(const frame& f,
+                                        const string_view_type& name) {
+    M_path.resize(f.length);
+    append_name(M_path, name);
+  }
+
+  void detail::glob_walker::pop() noexcept {
+    frame& f = M_stack[--M_depth];
+    f.cursor.finish();
+    f.dir.close();
+  }
+
+  void detail::glob_walker::use_listing_cache(listing_cache* cache) {
+    while (M_depth > 0) {
+      pop();
+    }
+    M_listings = cache;
+  }
+
+  bool detail::glob_walker::next(fs::path& out) {
+    if (!advance()) {
+      return false;
+    }
+    out = result();
+    return true;
+  }
+
+  bool detail::glob_walker::advance() {
+    if (!M_started) {
+      M_started = true;
+
+      if (M_pattern && !M_pattern->magic) {
+        const fs::path& pathname = M_pattern->pathname;
+        const bool found = pathname.has_filename()
+                               ? fs::exists(pathname)
+                               : fs::is_directory(pathname.parent_path());
+        if (found) {
+          M_path.assign(pathname.native());
+          M_result_length = M_path.size();
+        }
+        return found;
+      }
+
+      M_unique = M_pattern && !M_pattern->groups.empty();
+      if (!M_unique) {
+        push_root(*M_root);
+      }
+    }
+
+    // an entry matched by several patterns is yielded once for each of them
+    if (M_matched_pos < M_matched.size()) {
+      M_result_pattern = M_matched[M_matched_pos++];
+      return true;
+    }
+
+    do {
+      while (M_depth > 0) {
+        bool found;
+        switch (top().state) {
+          case start:
+            found = start_dir();
+            break;
+          case probe:
+            found = probe_dir();
+            break;
+          default:
+            found = list_dir();
+            break;
+        }
+
+        if (found) {
+          return true;
+        }
+      }
+    } while (next_group());
+
+    return false;
+  }
+
+  bool detail::glob_walker::next_group() {
+    if (!M_unique || M_group == M_pattern->groups.size()) {
+      return false;
+    }
+
+    const pattern_group& group = M_pattern->groups[M_group++];
+    M_rules.clear();
+    for (const auto& segments : group.segments) {
+      M_rules.add_pattern(segments);
+    }
+
+    push_root(group.root);
+    return true;
+  }
+
+  bool detail::glob_walker::start_dir() {
+    frame& f = top();
+
+    while (f.pos < f.states.size()) {
+      const walk_state& s = f.states[f.pos++];
+      if (M_rules.matches_self(s, f.length == 0, f.dir.is_open())) {
+        extend_path(f, string_view_type());
+        M_result_length = M_path.size();
+        M_result_pattern = s.pattern;
+
+        if (M_unique) {
+          // the directory is returned once, and the current directory
+          // matched by '**' is not a result (see remove_recursive_root)
+          f.pos = f.states.size();
+          if (M_result_length == 0) {
+            continue;
+          }
+        }
+        return true;
+      }
+    }
+
+    f.state = probe;
+    f.pos = 0L;
+    return false;
+  }
+
+  bool detail::glob_walker::probe_dir() {
+    frame& child = spare_frame();
+    frame& f = top();
+    const bool listing = M_rules.needs_listing(f.states);
+
+    // states which look up the same name (in several patterns, or in the
+    // alternatives of a brace pattern) share a single lookup
+    const auto same_probe = [&](std::size_t i, const fs::path& name,
+                                bool last) {
+      const fs::path* other = M_rules.probe_name(f.states[i], listing);
+      return other != nullptr && other->native() == name.native() &&
+             M_rules.is_last(f.states[i]) == last;
+    };
+
+    while (f.pos < f.states.size()) {
+      const std::size_t pos = f.pos++;
+      const fs::path* name = M_rules.probe_name(f.states[pos], listing);
+      if (name == nullptr) {
+        continue;
+      }
+
+      const bool last = M_rules.is_last(f.states[pos]);
+      bool probed = false;
+      for (std::size_t i = 0; i < pos && !probed; ++i) {
+        probed = same_probe(i, *name, last);
+      }
+      if (probed) {
+        continue;
+      }
+
+      if (last) {
+        if (f.dir.exists(*name)) {
+          M_matched.clear();
+          for (std::size_t i = pos; i < f.states.size(); ++i) {
+            const std::size_t p = f.states[i].pattern;
+            if (same_probe(i, *name, true) &&
+                std::find(M_matched.begin(), M_matched.end(), p) ==
+                    M_matched.end()) {
+              M_matched.push_back(p);
+            }
+          }
+
+          extend_path(f, name->native());
+          M_result_length = M_path.size();
+          M_result_pattern = M_matched[0];
+          M_matched_pos = M_unique ? M_matched.size() : 1L;
+          return true;
+        }
+        continue;
+      }
+
+      child.dir.open(f.dir, *name);
+      if (child.dir.is_open()) {
+        child.states.clear();
+        for (std::size_t i = pos; i < f.states.size(); ++i) {
+          if (same_probe(i, *name, false)) {
+            const walk_state& s = f.states[i];
+            M_rules.add_state(child.states, {s.pattern, s.index + 1, true});
+          }
+        }
+        extend_path(f, name->native());
+        child.length = M_path.size();
+        child.state = start;
+        child.pos = 0L;
+        ++M_depth;
+        return false;
+      }
+    }
+
+    if (listing) {
+      f.state = list;
+      f.cursor.start(f.dir, M_listings);
+    } else {
+      pop();
+    }
+    return false;
+  }
+
+  bool detail::glob_walker::list_dir() {
+    frame& child = spare_frame();
+    frame& f = top();
+    dir_entry entry;
+
+    while (f.cursor.next(f.dir, entry)) {
+      M_rules.match_entry(f.states, entry.name, M_next, M_matched);
+      const bool found = !M_matched.empty();
+      if (found) {
+        M_result_pattern = M_matched[0];
+        M_matched_pos = M_unique ? M_matched.size() : 1L;
+      }
+
+      // only entries which can still lead to a match are classified
+      if (!M_next.empty() && f.dir.is_directory(entry)) {
+        child.dir.open(f.dir, entry);
+        if (child.dir.is_open()) {
+          extend_path(f, entry.name);
+          child.length = M_path.size();
+          M_result_length = M_path.size();
+          child.states.assign(M_next.begin(), M_next.end());
+          child.state = start;
+          child.pos = 0L;
+          ++M_depth;
+          return found;
+        }
+      }
+
+      if (found) {
+        extend_path(f, entry.name);
+        M_result_length = M_path.size();
+        return true;
+      }
+    }
+
+    pop();
+    return false;
+  }
+}  // namespace cppglob
@@ -0,0 +1,302 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_GLOB_WALKER_HPP
+#define CPPGLOB_SRC_GLOB_WALKER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <cppglob/glob_iterator.hpp>
+#include "dir_reader.hpp"
+#include "listing_cache.hpp"
+#include "pattern_impl.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief append name to path like fs::path::operator/=
+     */
+    template <typename String>
+    CPPGLOB_INLINE void append_name(String& path,
+                                    const string_view_type& name) {
+      if (!path.empty()) {
+        const char_type last = path.back();
+#ifdef CPPGLOB_IS_WINDOWS
+        const bool separator = last == L'\\' || last == L'/' ||
+                               (path.size() == 2 && last == L':');
+#else
+        const bool separator = last == '/';
+#endif
+        if (!separator) {
+          path.push_back(fs::path::preferred_separator);
+        }
+      }
+      path.append(name.data(), name.size());
+    }
+
+    /**
+     * @brief position of a walk inside the segments of a pattern
+     */
+    struct CPPGLOB_LOCAL walk_state {
+      std::size_t pattern;
+      std::size_t index;
+
+      // entered without the self-loop of '**' (only relevant for '**')
+      bool fresh;
+    };
+
+    using state_list = std::pmr::vector<walk_state>;
+    using index_list = std::pmr::vector<std::size_t>;
+    using path_buffer = std::pmr::basic_string<char_type>;
+
+    /**
+     * @brief matching rules shared by the sequential and the parallel walk
+     *
+     * Every directory carries the set of pattern segments which still have
+     * to be matched against its entries. A '**' segment stays in the set of
+     * its subdirectories and also brings the segment after it into the set
+     * of the current directory, so a single listing serves both the
+     * recursion and the rest of the pattern. Segments of several patterns
+     * which start at the same root can share the same walk.
+     */
+    class CPPGLOB_LOCAL walk_rules {
+     public:
+      walk_rules() = default;
+
+      explicit walk_rules(std::pmr::memory_resource* resource)
+          : M_patterns(resource) {}
+
+      explicit walk_rules(const compiled_pattern& pat)
+          : M_patterns{&pat.segments} {}
+
+      explicit walk_rules(
+          const std::vector<const std::vector<pattern_segment>*>& patterns)
+          : M_patterns(patterns.begin(), patterns.end()) {}
+
+      bool is_last(const walk_state& state) const {
+        return state.index + 1 == M_patterns[state.pattern]->size();
+      }
+
+      /**
+       * @brief remove all patterns, keeping the allocated storage
+       */
+      void clear() noexcept { M_patterns.clear(); }
+
+      /**
+       * @brief add the segments of a pattern, which must outlive the rules
+       */
+      void add_pattern(const std::vector<pattern_segment>& segments) {
+        M_patterns.push_back(&segments);
+      }
+
+      /**
+       * @brief states of the root directory of the patterns
+       */
+      state_list initial_states() const;
+
+      /**
+       * @brief assign the states of the root directory to states
+       */
+      void initial_states(state_list& states) const;
+
+      /**
+       * @brief add state and every segment reachable from it without
+       * consuming a directory to states
+       */
+      void add_state(state_list& states, walk_state state) const;
+
+      /**
+       * @brief test whether state matches the directory itself (a trailing
+       * separator or '**' matching zero directories), in which case the
+       * directory with a trailing separator is a result
+       * @param empty the path of the directory is empty
+       */
+      bool matches_self(const walk_state& state, bool empty,
+                        bool is_open) const;
+
+      /**
+       * @brief test whether the entries of a directory have to be read
+       */
+      bool needs_listing(const state_list& states) const;
+
+      /**
+       * @brief return the literal name which is looked up directly for
+       * state, or nullptr
+       */
+      const fs::path* probe_name(const walk_state& state,
+                                 bool listing) const;
+
+      /**
+       * @brief match a directory entry against states
+       * @param next receives the states of the entry as a subdirectory
+       * @param matched receives the patterns for which the entry itself is a
+       * result
+       */
+      void match_entry(const state_list& states,
+                       const string_view_type& name, state_list& next,
+                       index_list& matched) const;
+
+     private:
+      const pattern_segment& segment(const walk_state& state) const {
+        return (*M_patterns[state.pattern])[state.index];
+      }
+
+      std::pmr::vector<const std::vector<pattern_segment>*> M_patterns;
+    };
+
+    /**
+     * @brief depth-first walk over the directories reachable by a pattern
+     *
+     * The walk is kept on an explicit stack of open directories, so that it
+     * can be suspended after every match. Memory usage is proportional to
+     * the depth of the walk and not to the number of results. Entries are
+     * only classified or opened if some segment matches their name, and
+     * results are built in a reused string buffer. The groups of a brace
+     * pattern are walked one after the other, and their results are
+     * returned once even if several alternatives match them.
+     *
+     * All frames share a single path buffer, in which each frame only
+     * records the length of its own path. Entering a directory or building
+     * a result appends a name to the path of the current frame, so every
+     * path is built exactly once however deep it is.
+     *
+     * Frames are not released when a directory is left but kept for the
+     * next directory at the same depth, together with their path, states
+     * and dirent buffer. A walker which is reset() for every walk therefore
+     * stops allocating once it has reached the deepest level of its walks.
+     * Everything the walker allocates comes from its memory resource.
+     */
+    class CPPGLOB_LOCAL glob_walker : public glob_source {
+     public:
+      explicit glob_walker(std::pmr::memory_resource* resource =
+                               std::pmr::get_default_resource());
+
+      explicit glob_walker(std::shared_ptr<const compiled_pattern> pat,
+                           std::pmr::memory_resource* resource =
+                               std::pmr::get_default_resource());
+
+      /**
+       * @brief walk several magic patterns from the same root at once
+       *
+       * The root and the segments are not copied and must outlive the
+       * walker.
+       */
+      glob_walker(
+          const fs::path& root,
+          const std::vector<const std::vector<pattern_segment>*>& patterns);
+
+      bool next(fs::path& out) override;
+
+      /**
+       * @brief abandon the current walk and start walking pat
+       */
+      void reset(std::shared_ptr<const compiled_pattern> pat);
+
+      /**
+       * @brief read the entries of directories through cache, which must
+       * outlive the walker (nullptr reads them directly)
+       *
+       * The current walk is abandoned.
+       */
+      void use_listing_cache(listing_cache* cache);
+
+      /**
+       * @brief find the next result without converting it to fs::path
+       * @return false if there are no more results
+       */
+      bool advance();
+
+      /**
+       * @brief return the result found by the last call of advance(), which
+       * is valid until the next call
+       */
+      string_view_type result() const noexcept {
+        return string_view_type(M_path.data(), M_result_length);
+      }
+
+      /**
+       * @brief return the index of the pattern which matched result()
+       */
+      std::size_t result_pattern() const noexcept { return M_result_pattern; }
+
+     private:
+      enum frame_state : unsigned char { start, probe, list };
+
+      struct frame {
+        explicit frame(std::pmr::memory_resource* resource)
+            : dir(resource), cursor(resource), states(resource) {}
+
+        dir_reader dir;
+        listing_cursor cursor;
+        std::size_t length = 0L;  // length of the path in M_path
+        state_list states;
+        frame_state state = start;
+        std::size_t pos = 0L;
+      };
+
+      frame& top() { return M_stack[M_depth - 1]; }
+
+      /**
+       * @brief return the unused frame above the top of the stack
+       */
+      frame& spare_frame();
+
+      /**
+       * @brief replace the end of M_path after the path of f with name
+       */
+      void extend_path(const frame& f, const string_view_type& name);
+
+      void push_root(const fs::path& root);
+      void pop() noexcept;
+
+      bool next_group();
+      bool start_dir();
+      bool probe_dir();
+      bool list_dir();
+
+      std::shared_ptr<const compiled_pattern> M_pattern;
+      const fs::path* M_root = nullptr;
+      walk_rules M_rules;
+
+      // M_depth frames in use, then spares (a deque keeps references to
+      // the frames valid while it grows)
+      std::pmr::deque<frame> M_stack;
+      std::size_t M_depth = 0L;
+      state_list M_next;
+      index_list M_matched;
+      std::size_t M_matched_pos = 0L;
+      path_buffer M_path;
+      std::size_t M_result_length = 0L;
+      std::size_t M_result_pattern = 0L;
+      std::size_t M_group = 0L;
+      listing_cache* M_listings = nullptr;
+      bool M_unique = false;  // walking the groups of a brace pattern
+      bool M_started = false;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
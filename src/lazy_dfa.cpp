@@ -0,0 +1,166 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "lazy_dfa.hpp"
+
+namespace cppglob {
+  detail::lazy_dfa::lazy_dfa(const std::vector<pattern_token>& tokens,
+                             const std::vector<char_class>& classes,
+                             const std::vector<std::size_t>& bounds,
+                             std::size_t max_states)
+      : M_tokens(tokens),
+        M_classes(classes),
+        M_final(tokens.size()),
+        M_words(tokens.size() / 64 + 1),
+        M_max_states(max_states) {
+    // every star but the virtual one at the end is a self-loop
+    M_loops.assign(M_words, 0);
+    for (std::size_t k = 0; k + 1 < bounds.size(); ++k) {
+      M_loops[bounds[k] / 64] |= word(1) << (bounds[k] % 64);
+    }
+
+    // narrow characters accepted by the same tokens share a class
+    using uchar = std::make_unsigned_t<char_type>;
+    std::map<std::string, unsigned char> signatures;
+    for (unsigned int u = 0; u < 256; ++u) {
+      const auto c = static_cast<char_type>(static_cast<uchar>(u));
+      std::string signature(M_tokens.size(), '0');
+      for (std::size_t i = 0; i < M_tokens.size(); ++i) {
+        if (token_matches(i, c)) {
+          signature[i] = '1';
+        }
+      }
+      const auto id = static_cast<unsigned char>(signatures.size());
+      M_class_of[u] = signatures.emplace(std::move(signature), id).first->second;
+    }
+    M_num_classes = signatures.size();
+
+    // the initial state (0) is the first position
+    M_initial.scratch.assign(M_words, 0);
+    M_initial.next.assign(M_words, 0);
+    M_initial.scratch[0] = 1;
+    state_of(M_initial, M_initial.scratch.data());
+  }
+
+  bool detail::lazy_dfa::token_matches(std::size_t i, char_type c) const {
+    const pattern_token& tok = M_tokens[i];
+    switch (tok.kind) {
+      case pattern_token::literal:
+        return tok.ch == c;
+      case pattern_token::bracket:
+        return M_classes[tok.index].contains(c);
+      default:
+        return true;
+    }
+  }
+
+  void detail::lazy_dfa::step(const word* in, char_type c, word* out) const {
+    std::fill(out, out + M_words, word(0));
+    for (std::size_t p = 0; p <= M_final; ++p) {
+      const word bit = word(1) << (p % 64);
+      if ((in[p / 64] & bit) == 0) {
+        continue;
+      }
+      out[p / 64] |= in[p / 64] & M_loops[p / 64] & bit;
+      if (p < M_final && token_matches(p, c)) {
+        out[(p + 1) / 64] |= word(1) << ((p + 1) % 64);
+      }
+    }
+  }
+
+  bool detail::lazy_dfa::simulate(cache& c,
+                                  const string_view_type& rest) const {
+    std::vector<word>& set = c.scratch;
+    for (char_type ch : rest) {
+      step(set.data(), ch, c.next.data());
+      set.swap(c.next);
+      if (std::all_of(set.begin(), set.end(), [](word w) { return w == 0; })) {
+        return false;
+      }
+    }
+    return accepts(set.data());
+  }
+
+  std::uint32_t detail::lazy_dfa::state_of(cache& c, const word* set) const {
+    std::vector<word> key(set, set + M_words);
+    auto it = c.index.find(key);
+    if (it != c.index.end()) {
+      return it->second;
+    }
+    if (c.accept.size() >= M_max_states) {
+      return unknown;
+    }
+
+    const auto id = static_cast<std::uint32_t>(c.accept.size());
+    c.sets.insert(c.sets.end(), set, set + M_words);
+    c.table.resize(c.table.size() + M_num_classes, unknown);
+    c.accept.push_back(accepts(set) ? 1 : 0);
+    if (std::all_of(key.begin(), key.end(), [](word w) { return w == 0; })) {
+      c.dead = id;
+    }
+    c.index.emplace(std::move(key), id);
+    return id;
+  }
+
+  bool detail::lazy_dfa::match(const string_view_type& name) const {
+    cache& c = M_caches.get(M_initial);
+
+    using uchar = std::make_unsigned_t<char_type>;
+    std::uint32_t state = 0;
+
+    for (std::size_t i = 0; i < name.size(); ++i) {
+      const char_type ch = name[i];
+      const bool narrow = is_narrow(ch);
+      const std::size_t slot =
+          narrow ? state * M_num_classes + M_class_of[static_cast<uchar>(ch)]
+                 : c.table.size();
+
+      std::uint32_t next = slot < c.table.size() ? c.table[slot] : unknown;
+      if (next == unknown) {
+        step(&c.sets[state * M_words], ch, c.scratch.data());
+        next = state_of(c, c.scratch.data());
+        if (next == unknown) {
+          // the cache is full
+          return simulate(c, name.substr(i + 1));
+        }
+        if (narrow) {
+          c.table[slot] = next;
+        }
+      }
+
+      state = next;
+      if (state == c.dead) {
+        return false;
+      }
+    }
+
+    return c.accept[state] != 0;
+  }
+}  // namespace cppglob
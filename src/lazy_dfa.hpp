@@ -0,0 +1,107 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_LAZY_DFA_HPP
+#define CPPGLOB_SRC_LAZY_DFA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "matcher.hpp"
+#include "thread_cache.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief DFA built on demand from the position automaton of a pattern
+     *
+     * A state of the underlying NFA is a position between two tokens; a
+     * star turns its position into a self-loop and a token moves to the
+     * next position. Sets of positions are turned into DFA states only when
+     * a name reaches them, and characters are grouped into classes which no
+     * token can tell apart. Matching is linear in the length of the name:
+     * once the cache holds max_states states, the set of positions is
+     * stepped directly (NFA simulation), which costs O(tokens) per
+     * character but never backtracks. Every thread builds its own cache
+     * (see thread_cache), so that parallel walks never wait for each other.
+     */
+    class CPPGLOB_LOCAL lazy_dfa {
+     public:
+      lazy_dfa(const std::vector<pattern_token>& tokens,
+               const std::vector<char_class>& classes,
+               const std::vector<std::size_t>& bounds,
+               std::size_t max_states = 1024L);
+
+      bool match(const string_view_type& name) const;
+
+     private:
+      using word = std::uint64_t;
+
+      static constexpr std::uint32_t unknown = ~std::uint32_t(0);
+
+      bool token_matches(std::size_t i, char_type c) const;
+
+      void step(const word* in, char_type c, word* out) const;
+
+      bool accepts(const word* set) const {
+        return ((set[M_final / 64] >> (M_final % 64)) & 1) != 0;
+      }
+
+      /**
+       * @brief states and transitions found so far, with the buffers of a
+       * match
+       */
+      struct cache {
+        std::vector<word> sets;
+        std::vector<std::uint32_t> table;
+        std::vector<unsigned char> accept;
+        std::map<std::vector<word>, std::uint32_t> index;
+        std::vector<word> scratch;
+        std::vector<word> next;
+        std::uint32_t dead = unknown;
+      };
+
+      // step c.scratch through rest
+      bool simulate(cache& c, const string_view_type& rest) const;
+
+      // return the state of a set of positions, or unknown if the cache is
+      // full
+      std::uint32_t state_of(cache& c, const word* set) const;
+
+      std::vector<pattern_token> M_tokens;
+      std::vector<char_class> M_classes;
+      std::vector<word> M_loops;  // positions following a star
+      std::size_t M_final;        // position after the last token
+      std::size_t M_words;        // words per set of positions
+
+      unsigned char M_class_of[256];  // character class of narrow characters
+      std::size_t M_num_classes = 0L;
+      std::size_t M_max_states;
+
+      cache M_initial;  // holds the initial state only
+      thread_cache<cache> M_caches;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
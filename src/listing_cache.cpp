@@ -0,0 +1,160 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "listing_cache.hpp"
+
+namespace cppglob {
+  detail::cached_listing* detail::listing_cache::acquire(const dir_status& st) {
+    const auto found = M_index.find({st.device, st.inode});
+    if (found == M_index.end()) {
+      return nullptr;
+    }
+
+    const lru_list::iterator it = found->second;
+    if (!(it->status == st)) {
+      if (it->users == 0) {
+        erase(it);
+      }
+      return nullptr;
+    }
+
+    M_lru.splice(M_lru.begin(), M_lru, it);
+    ++it->users;
+    return &*it;
+  }
+
+  void detail::listing_cache::release(cached_listing* listing) noexcept {
+    --listing->users;
+  }
+
+  bool detail::listing_cache::storable(const dir_status& st) {
+    using namespace std::chrono;
+    const auto now = system_clock::now().time_since_epoch();
+    const auto changed = seconds(st.ctime_sec) + nanoseconds(st.ctime_nsec);
+    return changed + seconds(1) < now;
+  }
+
+  void detail::listing_cache::store(
+      const dir_status& st, const string_view_type& names,
+      const std::pmr::vector<cached_listing::entry>& entries) {
+    const std::size_t weight = entries.size() + 1;
+    if (weight > M_max_entries) {
+      return;
+    }
+
+    const auto found = M_index.find({st.device, st.inode});
+    if (found != M_index.end()) {
+      if (found->second->users != 0) {
+        return;
+      }
+      erase(found->second);
+    }
+
+    // the least recently used listings which are not being read make room
+    for (auto it = M_lru.end();
+         M_size + weight > M_max_entries && it != M_lru.begin();) {
+      --it;
+      if (it->users == 0) {
+        erase(it++);
+      }
+    }
+    if (M_size + weight > M_max_entries) {
+      return;
+    }
+
+    M_lru.emplace_front();
+    cached_listing& listing = M_lru.front();
+    try {
+      listing.status = st;
+      listing.names.assign(names.data(), names.size());
+      listing.entries.assign(entries.begin(), entries.end());
+      M_index.emplace(key{st.device, st.inode}, M_lru.begin());
+    } catch (...) {
+      M_lru.pop_front();
+      throw;
+    }
+    M_size += weight;
+  }
+
+  void detail::listing_cache::erase(lru_list::iterator it) noexcept {
+    M_size -= it->entries.size() + 1;
+    M_index.erase({it->status.device, it->status.inode});
+    M_lru.erase(it);
+  }
+
+  void detail::listing_cursor::start(const dir_reader& dir,
+                                     listing_cache* cache) {
+    finish();
+    M_cache = cache;
+    M_pos = 0L;
+    if (cache == nullptr || !dir.status(M_status)) {
+      return;
+    }
+
+    M_listing = cache->acquire(M_status);
+    if (M_listing == nullptr && listing_cache::storable(M_status)) {
+      M_recording = true;
+      M_names.clear();
+      M_entries.clear();
+    }
+  }
+
+  bool detail::listing_cursor::next(dir_reader& dir, dir_entry& entry) {
+    if (M_listing != nullptr) {
+      if (M_pos == M_listing->entries.size()) {
+        return false;
+      }
+
+      const cached_listing::entry& e = M_listing->entries[M_pos++];
+      entry.name = string_view_type(M_listing->names.data() + e.offset,
+                                    e.length);
+      entry.type = e.type;
+      return true;
+    }
+
+    if (!dir.next(entry)) {
+      if (M_recording) {
+        M_recording = false;
+        M_cache->store(M_status, M_names, M_entries);
+      }
+      return false;
+    }
+
+    if (M_recording) {
+      M_entries.push_back({M_names.size(), entry.name.size(), entry.type});
+      M_names.append(entry.name.data(), entry.name.size());
+      M_names.push_back('\0');
+    }
+    return true;
+  }
+
+  void detail::listing_cursor::finish() noexcept {
+    if (M_listing != nullptr) {
+      M_cache->release(M_listing);
+      M_listing = nullptr;
+    }
+    M_recording = false;
+  }
+}  // namespace cppglob
@@ -0,0 +1,173 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_LISTING_CACHE_HPP
+#define CPPGLOB_SRC_LISTING_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cppglob/config.hpp>
+#include "dir_reader.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief entries of a directory kept by a listing_cache
+     */
+    struct CPPGLOB_LOCAL cached_listing {
+      struct entry {
+        std::size_t offset;  // of the name in names
+        std::size_t length;
+        entry_type type;
+      };
+
+      dir_status status;
+      string_type names;  // null-terminated names back to back
+      std::vector<entry> entries;
+      std::size_t users = 0L;  // cursors reading the listing
+    };
+
+    /**
+     * @brief size-bounded cache of directory listings
+     *
+     * Listings are keyed by the device and inode of the directory and are
+     * only reused while the status of the directory (one fstat(2)) is the
+     * same as when they were read. A listing is not stored if the
+     * directory changed less than a second before it was read, since a
+     * later change could then leave the status unchanged with coarse
+     * timestamps. The least recently used listings are dropped when the
+     * number of cached entries exceeds the bound, except for those which
+     * are being read.
+     */
+    class CPPGLOB_LOCAL listing_cache {
+     public:
+      /**
+       * @param max_entries bound of the cached entries (every directory
+       * counts as one more entry)
+       */
+      explicit listing_cache(std::size_t max_entries)
+          : M_max_entries(max_entries) {}
+
+      listing_cache(const listing_cache&) = delete;
+      listing_cache& operator=(const listing_cache&) = delete;
+
+      /**
+       * @brief return the listing of the directory with status st if it is
+       * still valid, which is kept until release(), or nullptr
+       */
+      cached_listing* acquire(const dir_status& st);
+
+      void release(cached_listing* listing) noexcept;
+
+      /**
+       * @brief test whether a listing of a directory whose status before
+       * reading was st may be stored
+       */
+      static bool storable(const dir_status& st);
+
+      /**
+       * @brief store the listing of a directory whose status before reading
+       * was st
+       */
+      void store(const dir_status& st, const string_view_type& names,
+                 const std::pmr::vector<cached_listing::entry>& entries);
+
+     private:
+      struct key {
+        std::uint64_t device;
+        std::uint64_t inode;
+
+        bool operator==(const key& other) const noexcept {
+          return device == other.device && inode == other.inode;
+        }
+      };
+
+      struct key_hash {
+        std::size_t operator()(const key& k) const noexcept {
+          return static_cast<std::size_t>(k.inode * 0x9E3779B97F4A7C15ULL ^
+                                          k.device);
+        }
+      };
+
+      using lru_list = std::list<cached_listing>;
+
+      void erase(lru_list::iterator it) noexcept;
+
+      lru_list M_lru;  // most recently used first
+      std::unordered_map<key, lru_list::iterator, key_hash> M_index;
+      std::size_t M_max_entries;
+      std::size_t M_size = 0L;
+    };
+
+    /**
+     * @brief reads the entries of a directory from a listing_cache when
+     * possible, and stores those which are read from the directory
+     *
+     * Without a cache, or if the status of the directory is not available,
+     * the entries are passed through from the dir_reader.
+     */
+    class CPPGLOB_LOCAL listing_cursor {
+     public:
+      explicit listing_cursor(std::pmr::memory_resource* resource)
+          : M_names(resource), M_entries(resource) {}
+
+      listing_cursor(const listing_cursor&) = delete;
+      listing_cursor& operator=(const listing_cursor&) = delete;
+
+      ~listing_cursor() { finish(); }
+
+      /**
+       * @brief start reading the entries of dir
+       */
+      void start(const dir_reader& dir, listing_cache* cache);
+
+      /**
+       * @brief read the next entry like dir_reader::next()
+       *
+       * Names read from the cache are null-terminated as well, so entries
+       * can be passed to dir_reader::is_directory() and opened.
+       */
+      bool next(dir_reader& dir, dir_entry& entry);
+
+      /**
+       * @brief stop reading, releasing the cached listing
+       */
+      void finish() noexcept;
+
+     private:
+      listing_cache* M_cache = nullptr;
+      cached_listing* M_listing = nullptr;  // the entries come from here
+      std::size_t M_pos = 0L;
+      bool M_recording = false;
+      dir_status M_status;
+      std::pmr::basic_string<char_type> M_names;
+      std::pmr::vector<cached_listing::entry> M_entries;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include "matcher.hpp"
+
+#if !defined(CPPGLOB_IS_WINDOWS) &&               \
+    (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#  define CPPGLOB_USE_X86_SIMD 1
+#  include <immintrin.h>
+#endif
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE void set_bit(std::uint64_t* bitmap, std::size_t i) {
+      bitmap[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+
+    /**
+     * @brief names stored back to back with one end offset per name
+     */
+    struct CPPGLOB_LOCAL batch_names {
+      const char_type* data;
+      std::size_t size;  // length of the whole buffer
+      const std::size_t* ends;
+      std::size_t count;
+    };
+
+#ifdef CPPGLOB_USE_X86_SIMD
+#  define CPPGLOB_SIMD_TARGET(isa) __attribute__((target(isa)))
+#  define CPPGLOB_SIMD_INLINE static inline __attribute__((always_inline))
+#  define CPPGLOB_SIMD_INLINE_MEMBER inline __attribute__((always_inline))
+
+// The kernels below are templates without a target attribute, but they are
+// only ever inlined into batch_sse2() and batch_avx2(), so that vectors never
+// cross a function call.
+#  if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wpsabi"
+#  endif
+
+    /**
+     * @brief literal parts of a matcher prepared for vector compares
+     */
+    struct CPPGLOB_LOCAL batch_literals {
+      matcher::shape_type shape;
+      string_view_type head;
+      string_view_type tail;
+    };
+
+    struct CPPGLOB_LOCAL sse2_ops {
+      using vec = __m128i;
+      static constexpr std::size_t width = 16;
+
+      CPPGLOB_SIMD_TARGET("sse2") static vec load(const char* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      }
+
+      CPPGLOB_SIMD_TARGET("sse2") static vec broadcast(char c) {
+        return _mm_set1_epi8(c);
+      }
+
+      CPPGLOB_SIMD_TARGET("sse2")
+      static std::uint32_t equal(const vec& a, const vec& b) {
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+      }
+    };
+
+    struct CPPGLOB_LOCAL avx2_ops {
+      using vec = __m256i;
+      static constexpr std::size_t width = 32;
+
+      CPPGLOB_SIMD_TARGET("avx2") static vec load(const char* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+      }
+
+      CPPGLOB_SIMD_TARGET("avx2") static vec broadcast(char c) {
+        return _mm256_set1_epi8(c);
+      }
+
+      CPPGLOB_SIMD_TARGET("avx2")
+      static std::uint32_t equal(const vec& a, const vec& b) {
+        return static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+      }
+    };
+
+    CPPGLOB_SIMD_INLINE std::uint32_t low_bits(std::size_t n) {
+      return n >= 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << n) - 1;
+    }
+
+    /**
+     * @brief literal anchor compared with a single vector load when the
+     * load stays inside the buffer
+     */
+    template <typename Ops>
+    struct CPPGLOB_LOCAL simd_anchor {
+      typename Ops::vec chars;
+      std::uint32_t mask;
+      bool fits;
+      string_view_type lit;
+
+      CPPGLOB_SIMD_INLINE_MEMBER explicit simd_anchor(
+          const string_view_type& str)
+          : mask(low_bits(str.size())),
+            fits(str.size() <= Ops::width),
+            lit(str) {
+        char buf[Ops::width] = {};
+        if (fits) {
+          std::memcpy(buf, str.data(), str.size());
+        }
+        chars = Ops::load(buf);
+      }
+    };
+
+    template <typename Ops>
+    CPPGLOB_SIMD_INLINE bool anchor_equal(const simd_anchor<Ops>& a,
+                                          const char* s, const char* limit) {
+      if (a.fits && s + Ops::width <= limit) {
+        return (Ops::equal(Ops::load(s), a.chars) & a.mask) == a.mask;
+      }
+      return std::memcmp(s, a.lit.data(), a.lit.size()) == 0;
+    }
+
+    /**
+     * @brief substring search comparing the first and the last character
+     * of the literal at every position of a vector, and the rest only for
+     * the candidates
+     */
+    template <typename Ops>
+    CPPGLOB_SIMD_INLINE bool simd_contains(const char* s, std::size_t n,
+                                           const char* limit,
+                                           const string_view_type& lit,
+                                           const typename Ops::vec& first,
+                                           const typename Ops::vec& last) {
+      const std::size_t k = lit.size();
+      if (k == 0) {
+        return true;
+      }
+      if (n < k) {
+        return false;
+      }
+
+      const std::size_t candidates = n - k + 1;
+      std::size_t i = 0L;
+
+      for (; i < candidates; i += Ops::width) {
+        const char* p = s + i;
+        if (p + k - 1 + Ops::width > limit) {
+          break;
+        }
+
+        std::uint32_t mask = Ops::equal(Ops::load(p), first) &
+                             Ops::equal(Ops::load(p + k - 1), last) &
+                             low_bits(candidates - i);
+        while (mask != 0) {
+          const unsigned j = static_cast<unsigned>(__builtin_ctz(mask));
+          if (k <= 2 || std::memcmp(p + j + 1, lit.data() + 1, k - 2) == 0) {
+            return true;
+          }
+          mask &= mask - 1;
+        }
+      }
+
+      // the last names of the buffer
+      return i < candidates &&
+             string_view_type(s + i, n - i).find(lit) != string_view_type::npos;
+    }
+
+    template <typename Ops>
+    CPPGLOB_SIMD_INLINE std::size_t batch_kernel(const batch_literals& lits,
+                                                 const batch_names& names,
+                                                 std::uint64_t* bitmap) {
+      const char* const limit = names.data + names.size;
+      const simd_anchor<Ops> head(lits.head);
+      const simd_anchor<Ops> tail(lits.tail);
+      const std::size_t head_len = lits.head.size();
+      const std::size_t tail_len = lits.tail.size();
+
+      const char lit_first = head_len > 0 ? lits.head.front() : '\0';
+      const char lit_last = head_len > 0 ? lits.head.back() : '\0';
+      const typename Ops::vec first = Ops::broadcast(lit_first);
+      const typename Ops::vec last = Ops::broadcast(lit_last);
+
+      std::size_t begin = 0L, found = 0L;
+      for (std::size_t i = 0; i < names.count; ++i) {
+        const char* s = names.data + begin;
+        const std::size_t n = names.ends[i] - begin;
+        begin = names.ends[i];
+
+        bool ok;
+        switch (lits.shape) {
+          case matcher::exact:
+            ok = n == head_len && anchor_equal(head, s, limit);
+            break;
+          case matcher::prefix:
+            ok = n >= head_len && anchor_equal(head, s, limit);
+            break;
+          case matcher::suffix:
+            ok = n >= tail_len && anchor_equal(tail, s + n - tail_len, limit);
+            break;
+          case matcher::prefix_suffix:
+            ok = n >= head_len + tail_len && anchor_equal(head, s, limit) &&
+                 anchor_equal(tail, s + n - tail_len, limit);
+            break;
+          default:
+            ok = simd_contains<Ops>(s, n, limit, lits.head, first, last);
+            break;
+        }
+
+        // without a branch, the results of a listing are hardly predictable
+        bitmap[i / 64] |= std::uint64_t(ok) << (i % 64);
+        found += ok;
+      }
+
+      return found;
+    }
+
+    CPPGLOB_SIMD_TARGET("sse2")
+    CPPGLOB_INLINE std::size_t batch_sse2(const batch_literals& lits,
+                                          const batch_names& names,
+                                          std::uint64_t* bitmap) {
+      return batch_kernel<sse2_ops>(lits, names, bitmap);
+    }
+
+    CPPGLOB_SIMD_TARGET("avx2")
+    CPPGLOB_INLINE std::size_t batch_avx2(const batch_literals& lits,
+                                          const batch_names& names,
+                                          std::uint64_t* bitmap) {
+      return batch_kernel<avx2_ops>(lits, names, bitmap);
+    }
+
+    using batch_function = std::size_t (*)(const batch_literals&,
+                                           const batch_names&,
+                                           std::uint64_t*);
+
+    /**
+     * @brief choose the widest instruction set supported by the processor
+     */
+    CPPGLOB_INLINE batch_function select_batch() {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+        return batch_avx2;
+      }
+      if (__builtin_cpu_supports("sse2")) {
+        return batch_sse2;
+      }
+      return nullptr;
+    }
+
+#  if defined(__GNUC__) && !defined(__clang__)
+#    pragma GCC diagnostic pop
+#  endif
+#endif
+  }  // namespace detail
+
+  std::size_t detail::matcher::match_batch(const char_type* data,
+                                           const std::size_t* ends,
+                                           std::size_t count,
+                                           std::uint64_t* bitmap) const {
+    std::fill(bitmap, bitmap + (count + 63) / 64, std::uint64_t(0));
+    if (count == 0) {
+      return 0L;
+    }
+
+    const batch_names names{data, ends[count - 1], ends, count};
+
+#ifdef CPPGLOB_USE_X86_SIMD
+    // the kernels compare raw bytes, while a case-insensitive pattern may
+    // have to fold the names (see match())
+    static const batch_function simd = select_batch();
+    if (simd != nullptr && M_shape != general && !M_icase) {
+      return simd({M_shape, M_head, M_tail}, names, bitmap);
+    }
+#endif
+
+    std::size_t begin = 0L, found = 0L;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (match(string_view_type(data + begin, ends[i] - begin))) {
+        set_bit(bitmap, i);
+        ++found;
+      }
+      begin = ends[i];
+    }
+
+    return found;
+  }
+}  // namespace cppglob
@@ -0,0 +1,406 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "extglob.hpp"
+#include "lazy_dfa.hpp"
+#include "matcher.hpp"
+#include "shift_and.hpp"
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE bool equal_chars(const char_type* s,
+                                    const string_type& lit) {
+      using traits = std::char_traits<char_type>;
+      return traits::compare(s, lit.data(), lit.size()) == 0;
+    }
+
+    CPPGLOB_INLINE bool contains(const string_view_type& name,
+                                 const string_type& lit) {
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+      return ::memmem(name.data(), name.size(), lit.data(), lit.size()) !=
+             nullptr;
+#else
+      return name.find(lit) != string_view_type::npos;
+#endif
+    }
+
+    CPPGLOB_INLINE bool is_ascii(const string_view_type& str) {
+      using uchar = std::make_unsigned_t<char_type>;
+      uchar bits = 0;
+      for (const char_type c : str) {
+        bits |= static_cast<uchar>(c);
+      }
+      return bits < 0x80;
+    }
+  }  // namespace detail
+
+  detail::char_class detail::parse_class(const string_view_type& stuff,
+                                         bool icase) {
+    char_class cls;
+    cls.icase = icase;
+    std::size_t k = 0L, n = stuff.size();
+
+    if (n > 0 && stuff[0] == '!') {
+      cls.negated = true;
+      ++k;
+    }
+
+    while (k < n) {
+      if (k + 2 < n && stuff[k + 1] == '-') {
+        cls.ranges.emplace_back(stuff[k], stuff[k + 2]);
+        k += 3;
+      } else {
+        cls.ranges.emplace_back(stuff[k], stuff[k]);
+        ++k;
+      }
+    }
+
+    cls.compile();
+    return cls;
+  }
+
+  std::size_t detail::find_bracket_end(const string_view_type& pat,
+                                       std::size_t first) {
+    const std::size_t n = pat.size();
+    std::size_t j = first;
+    if (j < n && pat[j] == '!') {
+      ++j;
+    }
+    if (j < n && pat[j] == ']') {
+      ++j;
+    }
+    while (j < n && pat[j] != ']') {
+      ++j;
+    }
+    return j < n ? j : string_view_type::npos;
+  }
+
+  detail::pattern_token detail::literal_token(
+      char_type c, bool icase, std::vector<char_class>& classes) {
+    char_type variants[max_case_variants];
+    const std::size_t n = icase ? case_variants(c, variants) : 1L;
+    if (n == 1) {
+      return {pattern_token::literal, c, 0L};
+    }
+
+    char_class cls;
+    for (std::size_t i = 0; i < n; ++i) {
+      cls.ranges.emplace_back(variants[i], variants[i]);
+    }
+    cls.compile();
+    classes.push_back(std::move(cls));
+    return {pattern_token::bracket, c, classes.size() - 1};
+  }
+
+  detail::matcher::matcher(const string_view_type& pattern,
+                           pattern_flags flags) {
+    M_icase = (flags & pattern_flags::case_insensitive) != pattern_flags::none;
+
+    // characters outside of bracket expressions are folded
+    string_type folded;
+    string_view_type pat = pattern;
+    if (M_icase) {
+      std::size_t first = 0L;
+      for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != '[') {
+          continue;
+        }
+        const std::size_t end = find_bracket_end(pattern, i + 1);
+        if (end != string_view_type::npos) {
+          fold_string(pattern.substr(first, i - first), folded);
+          folded.append(pattern.data() + i, end + 1 - i);
+          first = end + 1;
+          i = end;
+        }
+      }
+      fold_string(pattern.substr(first), folded);
+      pat = folded;
+    }
+
+    if ((flags & pattern_flags::extglob) != pattern_flags::none &&
+        has_extglob(pat)) {
+      // groups are matched by an automaton of their own
+      M_shape = general;
+      M_bounds.push_back(0L);
+      M_extglob = std::make_shared<extglob_dfa>(pat, M_icase);
+      return;
+    }
+
+    std::size_t i = 0L, n = pat.size();
+    bool star = false;
+    M_tokens.reserve(n);
+
+    while (i < n) {
+      auto c = pat[i];
+      ++i;
+
+      if (c == '*') {
+        // consecutive stars are the same as a single one
+        if (!star) {
+          M_bounds.push_back(M_tokens.size());
+        }
+        star = true;
+        continue;
+      }
+      star = false;
+
+      if (c == '?') {
+        M_tokens.push_back({pattern_token::any, c, 0L});
+      } else if (c == '[') {
+        // bracket expressions are delimited exactly like translate() does
+        const std::size_t j = find_bracket_end(pat, i);
+        if (j == string_view_type::npos) {
+          // close parenthesis not found.
+          M_tokens.push_back({pattern_token::literal, c, 0L});
+        } else {
+          M_classes.push_back(parse_class(pat.substr(i, j - i), M_icase));
+          M_tokens.push_back(
+              {pattern_token::bracket, c, M_classes.size() - 1});
+          i = j + 1;
+        }
+      } else {
+        M_tokens.push_back(literal_token(c, M_icase, M_classes));
+      }
+    }
+
+    M_bounds.push_back(M_tokens.size());
+    classify();
+  }
+
+  void detail::matcher::classify() {
+    for (const pattern_token& tok : M_tokens) {
+      if (tok.kind != pattern_token::literal) {
+        M_shape = general;
+        break;
+      }
+    }
+
+    if (M_shape != general) {
+      classify_literal();
+    }
+
+    // without middle segments only the anchored ends are compared
+    if (M_shape != general || M_bounds.size() <= 2) {
+      return;
+    }
+
+    if (M_tokens.size() <= shift_and::max_tokens) {
+      M_shift_and =
+          std::make_shared<shift_and>(M_tokens, M_classes, M_bounds);
+      return;
+    }
+
+    for (std::size_t i = 1; i + 1 < M_bounds.size(); ++i) {
+      if (M_bounds[i] - M_bounds[i - 1] > 1) {
+        M_dfa = std::make_shared<lazy_dfa>(M_tokens, M_classes, M_bounds);
+        break;
+      }
+    }
+  }
+
+  void detail::matcher::classify_literal() {
+    const auto literal = [this](std::size_t first, std::size_t last) {
+      string_type str;
+      for (std::size_t i = first; i < last; ++i) {
+        str.push_back(M_tokens[i].ch);
+      }
+      return str;
+    };
+
+    const std::size_t stars = M_bounds.size() - 1;
+    const std::size_t head_len = M_bounds[0];
+
+    if (stars == 0) {
+      M_shape = exact;
+      M_head = literal(0L, head_len);
+    } else if (stars == 1) {
+      M_head = literal(0L, head_len);
+      M_tail = literal(head_len, M_tokens.size());
+      M_shape = M_tail.empty() ? prefix
+                               : M_head.empty() ? suffix : prefix_suffix;
+    } else if (stars == 2 && head_len == 0 &&
+               M_bounds[1] == M_tokens.size()) {
+      M_shape = infix;
+      M_head = literal(0L, M_tokens.size());
+    } else {
+      M_shape = general;
+    }
+  }
+
+  string_type detail::matcher::required_literal() const {
+    std::size_t best_first = 0L, best_len = 0L;
+    std::size_t first = 0L;
+
+    for (std::size_t bound : M_bounds) {
+      // runs of literal tokens never cross a star
+      for (std::size_t i = first; i <= bound; ++i) {
+        if (i < bound && M_tokens[i].kind == pattern_token::literal) {
+          continue;
+        }
+        if (i - first > best_len) {
+          best_first = first;
+          best_len = i - first;
+        }
+        first = i + 1;
+      }
+      first = bound;
+    }
+
+    string_type lit;
+    for (std::size_t i = best_first; i < best_first + best_len; ++i) {
+      lit.push_back(M_tokens[i].ch);
+    }
+    return lit;
+  }
+
+  bool detail::matcher::match_at(std::size_t first, std::size_t last,
+                                 const char_type* s) const {
+    for (std::size_t i = first; i < last; ++i, ++s) {
+      const pattern_token& tok = M_tokens[i];
+      switch (tok.kind) {
+        case pattern_token::literal:
+          if (*s != tok.ch) return false;
+          break;
+        case pattern_token::bracket:
+          if (!M_classes[tok.index].contains(*s)) return false;
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+  }
+
+  std::size_t detail::matcher::find(std::size_t first, std::size_t last,
+                                    const string_view_type& name,
+                                    std::size_t pos, std::size_t end) const {
+    const std::size_t len = last - first;
+    const pattern_token& head = M_tokens[first];
+
+    while (pos + len <= end) {
+      if (head.kind == pattern_token::literal) {
+        // skip directly to the next candidate position
+        pos = name.find(head.ch, pos);
+        if (pos == string_view_type::npos || pos + len > end) {
+          break;
+        }
+      }
+
+      if (match_at(first, last, name.data() + pos)) {
+        return pos;
+      }
+      ++pos;
+    }
+
+    return string_view_type::npos;
+  }
+
+  bool detail::matcher::match(const string_view_type& name) const {
+#ifndef CPPGLOB_IS_WINDOWS
+    // the tokens only know the case variants of ASCII letters
+    if (M_icase && !is_ascii(name)) {
+      thread_local string_type folded;
+      folded.clear();
+      fold_string(name, folded);
+      return match_name(folded);
+    }
+#endif
+    return match_name(name);
+  }
+
+  bool detail::matcher::match_name(const string_view_type& name) const {
+    const std::size_t n = name.size();
+
+    switch (M_shape) {
+      case exact:
+        return n == M_head.size() && equal_chars(name.data(), M_head);
+      case prefix:
+        return n >= M_head.size() && equal_chars(name.data(), M_head);
+      case suffix:
+        return n >= M_tail.size() &&
+               equal_chars(name.data() + n - M_tail.size(), M_tail);
+      case prefix_suffix:
+        return n >= M_head.size() + M_tail.size() &&
+               equal_chars(name.data(), M_head) &&
+               equal_chars(name.data() + n - M_tail.size(), M_tail);
+      case infix:
+        return contains(name, M_head);
+      default:
+        if (M_shift_and) {
+          return M_shift_and->match(name);
+        }
+        if (M_extglob) {
+          return M_extglob->match(name);
+        }
+        return M_dfa ? M_dfa->match(name) : match_general(name);
+    }
+  }
+
+  bool detail::matcher::match_path(const fs::path& name) const {
+    const string_type& str = name.native();
+    if (is_normal(str)) {
+      return match(str);
+    }
+    return match(name.lexically_normal().native());
+  }
+
+  bool detail::matcher::match_general(const string_view_type& name) const {
+    const std::size_t stars = M_bounds.size() - 1;
+    const std::size_t n = name.size();
+    const std::size_t head_len = M_bounds[0];
+
+    if (stars == 0) {
+      return n == head_len && match_at(0L, head_len, name.data());
+    }
+
+    const std::size_t tail_first = M_bounds[stars - 1];
+    const std::size_t tail_len = M_tokens.size() - tail_first;
+
+    if (n < head_len + tail_len || !match_at(0L, head_len, name.data()) ||
+        !match_at(tail_first, M_tokens.size(), name.data() + n - tail_len)) {
+      return false;
+    }
+
+    std::size_t pos = head_len;
+    const std::size_t end = n - tail_len;
+
+    for (std::size_t i = 1; i < stars; ++i) {
+      const std::size_t first = M_bounds[i - 1];
+      const std::size_t last = M_bounds[i];
+      if (first == last) {
+        continue;
+      }
+
+      pos = find(first, last, name, pos, end);
+      if (pos == string_view_type::npos) {
+        return false;
+      }
+      pos += last - first;
+    }
+
+    return true;
+  }
+}  // namespace cppglob
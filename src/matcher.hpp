@@ -0,0 +1,257 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_MATCHER_HPP
+#define CPPGLOB_SRC_MATCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cppglob/fnmatch.hpp>
+#include <cppglob/pattern.hpp>
+#include "case_fold.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief test whether c is below 256, i.e. has an entry in the tables
+     * which are indexed by narrow characters (always true for char)
+     */
+    template <typename Char>
+    constexpr bool is_narrow(Char c) noexcept {
+      if constexpr (sizeof(Char) == 1) {
+        return true;
+      } else {
+        return static_cast<std::make_unsigned_t<Char>>(c) < 256;
+      }
+    }
+
+    /**
+     * @brief set of characters described by a bracket expression
+     *
+     * Characters below 256, i.e. every narrow character, are tested with a
+     * single lookup in a bitmap which already accounts for negation and
+     * case. Wider characters fall back to the list of ranges. If icase is
+     * set, a character is in the class if any of its case variants is in
+     * the ranges.
+     */
+    struct CPPGLOB_LOCAL char_class {
+      std::vector<std::pair<char_type, char_type>> ranges;
+      bool negated = false;
+      bool icase = false;
+      std::uint64_t bits[4] = {};
+
+      /**
+       * @brief build the bitmap from ranges, negated and icase
+       */
+      void compile() {
+        using uchar = std::make_unsigned_t<char_type>;
+        for (unsigned int i = 0; i < 256; ++i) {
+          if (in_class(static_cast<char_type>(static_cast<uchar>(i))) !=
+              negated) {
+            bits[i / 64] |= std::uint64_t(1) << (i % 64);
+          }
+        }
+      }
+
+      bool contains(char_type c) const {
+        if (is_narrow(c)) {
+          const auto u = static_cast<std::make_unsigned_t<char_type>>(c);
+          return ((bits[u / 64] >> (u % 64)) & 1) != 0;
+        }
+        return in_class(c) != negated;
+      }
+
+     private:
+      bool in_class(char_type c) const {
+        if (!icase) {
+          return in_ranges(c);
+        }
+
+        char_type variants[max_case_variants];
+        const std::size_t n = case_variants(c, variants);
+        for (std::size_t i = 0; i < n; ++i) {
+          if (in_ranges(variants[i])) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      bool in_ranges(char_type c) const {
+        for (auto&& r : ranges) {
+          if (r.first <= c && c <= r.second) {
+            return true;
+          }
+        }
+        return false;
+      }
+    };
+
+    /**
+     * @brief parse the contents of a bracket expression
+     * @param icase ignore case
+     */
+    CPPGLOB_LOCAL char_class parse_class(const string_view_type& stuff,
+                                         bool icase);
+
+    /**
+     * @brief find the ']' which closes a bracket expression whose contents
+     * start at first, with the same rules as translate()
+     * @return position of the ']', or npos
+     */
+    CPPGLOB_LOCAL std::size_t find_bracket_end(const string_view_type& pat,
+                                               std::size_t first);
+
+    /**
+     * @brief single character test of a compiled shell pattern
+     */
+    struct CPPGLOB_LOCAL pattern_token {
+      enum kind_type : unsigned char { literal, any, bracket };
+
+      kind_type kind;
+      char_type ch;       // character to be compared (literal)
+      std::size_t index;  // index of the character class (bracket)
+    };
+
+    /**
+     * @brief return the token which matches c, or a bracket token which
+     * matches every case variant of c if icase is set and c has any
+     */
+    CPPGLOB_LOCAL pattern_token literal_token(char_type c, bool icase,
+                                              std::vector<char_class>& classes);
+
+    class extglob_dfa;
+    class lazy_dfa;
+    class shift_and;
+
+    /**
+     * @brief shell pattern compiled into a wildcard matching program
+     *
+     * The pattern is stored as the '*'-separated segments S0*S1*...*Sk.
+     * Every token of a segment consumes exactly one character, so the first
+     * and the last segments are anchored at both ends of the name and each
+     * middle segment is searched at its leftmost position. No backtracking
+     * over a previous '*' is ever needed.
+     *
+     * Patterns made of literal characters and at most two stars in the
+     * common shapes ("abc", "abc*", "*abc", "ab*c", "*abc*") are matched by
+     * plain string comparisons instead. Patterns with middle segments,
+     * which have to be searched, are simulated bit-parallel (Shift-And) when
+     * they have fewer than 128 tokens. Longer ones are matched by a lazily
+     * built DFA if a middle segment has more than one token, since the
+     * search could otherwise cost O(name * segment). Patterns with
+     * extended groups ("@(a|b)") are matched by a DFA of their own.
+     *
+     * Without case, the pattern is folded once and every letter becomes a
+     * bracket token of its case variants, so that all engines match names
+     * as they are. Only POSIX names with multibyte characters are folded
+     * first, into a buffer which is reused by the thread.
+     */
+    class CPPGLOB_LOCAL matcher {
+     public:
+      enum shape_type : unsigned char {
+        exact,          // abc
+        prefix,         // abc*
+        suffix,         // *abc
+        prefix_suffix,  // ab*c
+        infix,          // *abc*
+        general
+      };
+
+      matcher() = default;
+
+      /**
+       * @param flags pattern_flags::extglob and case_insensitive are used
+       */
+      explicit matcher(const string_view_type& pat,
+                       pattern_flags flags = pattern_flags::none);
+
+      bool match(const string_view_type& name) const;
+
+      /**
+       * @brief match the lexically normalized form of a path
+       *
+       * Paths which are already normal are matched without a copy.
+       */
+      bool match_path(const fs::path& name) const;
+
+      /**
+       * @brief match every name of a buffer at once
+       *
+       * The literal anchors of the common shapes are compared with SSE2 or
+       * AVX2, chosen at run time, on x86 processors.
+       * @param data names stored back to back
+       * @param ends end offset of each name in data
+       * @param bitmap receives one bit per name ((count + 63) / 64 words)
+       * @return number of matching names
+       */
+      std::size_t match_batch(const char_type* data, const std::size_t* ends,
+                              std::size_t count, std::uint64_t* bitmap) const;
+
+      shape_type shape() const noexcept { return M_shape; }
+
+      /**
+       * @brief return the longest run of literal characters which every
+       * matching name contains (empty if there is none)
+       */
+      string_type required_literal() const;
+
+     private:
+      void classify();
+      void classify_literal();
+
+      bool match_name(const string_view_type& name) const;
+
+      bool match_general(const string_view_type& name) const;
+
+      bool match_at(std::size_t first, std::size_t last,
+                    const char_type* s) const;
+
+      std::size_t find(std::size_t first, std::size_t last,
+                       const string_view_type& name, std::size_t pos,
+                       std::size_t end) const;
+
+      std::vector<pattern_token> M_tokens;
+      std::vector<char_class> M_classes;
+
+      // end offsets of each segment in M_tokens
+      std::vector<std::size_t> M_bounds;
+
+      // literal parts of the pattern (shape != general)
+      shape_type M_shape = exact;
+      bool M_icase = false;
+      string_type M_head;
+      string_type M_tail;
+
+      // linear-time engines for general patterns with middle segments
+      std::shared_ptr<const shift_and> M_shift_and;
+      std::shared_ptr<const lazy_dfa> M_dfa;
+      std::shared_ptr<const extglob_dfa> M_extglob;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <filesystem>
+#include "parallel_walker.hpp"
+
+namespace cppglob {
+  detail::parallel_walker::parallel_walker(const compiled_pattern& pat,
+                                           unsigned int threads, bool ordered)
+      : M_pattern(pat),
+        M_rules(pat),
+        M_ordered(ordered),
+        M_pending(0L),
+        M_failed(false),
+        M_queued(0L),
+        M_sleeping(0L) {
+    for (unsigned int i = 0; i < threads; ++i) {
+      M_workers.push_back(std::make_unique<worker>());
+    }
+  }
+
+  detail::parallel_walker::~parallel_walker() {
+    // tasks left behind by an error are owned by their deque in unordered
+    // mode
+    if (!M_ordered) {
+      for (std::unique_ptr<worker>& w : M_workers) {
+        for (task* t : w->tasks) {
+          delete t;
+        }
+      }
+    }
+  }
+
+  std::vector<fs::path> detail::parallel_walker::run() {
+    task root{M_pattern.root, M_rules.initial_states(), true, {}, {}};
+
+    // the root is read before any thread is started, so that its results
+    // come first in every mode
+    process(*M_workers[0], root);
+
+    std::vector<std::thread> threads;
+    try {
+      for (std::size_t id = 1; id < M_workers.size(); ++id) {
+        threads.emplace_back(&parallel_walker::work, this, id);
+      }
+    } catch (...) {
+      M_failed = true;
+      wake_all();
+      for (std::thread& th : threads) {
+        th.join();
+      }
+      throw;
+    }
+
+    work(0L);
+    for (std::thread& th : threads) {
+      th.join();
+    }
+
+    if (M_error) {
+      std::rethrow_exception(M_error);
+    }
+
+    if (M_ordered) {
+      return flatten(root);
+    }
+
+    std::vector<fs::path> files = std::move(M_workers[0]->found);
+    for (std::size_t id = 1; id < M_workers.size(); ++id) {
+      std::vector<fs::path>& found = M_workers[id]->found;
+      files.insert(files.end(), std::make_move_iterator(found.begin()),
+                   std::make_move_iterator(found.end()));
+    }
+    return files;
+  }
+
+  void detail::parallel_walker::work(std::size_t id) {
+    worker& w = *M_workers[id];
+
+    while (!M_failed) {
+      task* t = pop(id);
+      if (t == nullptr) {
+        if (M_pending == 0L) {
+          break;
+        }
+        wait_for_task();
+        continue;
+      }
+
+      try {
+        process(w, *t);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(M_error_mutex);
+        if (!M_error) {
+          M_error = std::current_exception();
+        }
+        M_failed = true;
+        wake_all();
+      }
+
+      if (!M_ordered) {
+        delete t;
+      }
+
+      // decremented after the subdirectories have been pushed
+      if (--M_pending == 0L) {
+        wake_all();
+      }
+    }
+  }
+
+  void detail::parallel_walker::wait_for_task() {
+    // spawn() only notifies if it sees a sleeping thread, so the count is
+    // raised before the queue is checked again under the lock
+    std::unique_lock<std::mutex> lock(M_idle_mutex);
+    ++M_sleeping;
+    M_idle.wait(lock, [this] {
+      return M_queued > 0L || M_pending == 0L || M_failed;
+    });
+    --M_sleeping;
+  }
+
+  void detail::parallel_walker::wake_all() {
+    std::lock_guard<std::mutex> lock(M_idle_mutex);
+    M_idle.notify_all();
+  }
+
+  detail::parallel_walker::task* detail::parallel_walker::pop(std::size_t id) {
+    {
+      worker& w = *M_workers[id];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (!w.tasks.empty()) {
+        task* t = w.tasks.back();
+        w.tasks.pop_back();
+        --M_queued;
+        return t;
+      }
+    }
+
+    // steal the oldest task, which is the closest one to the root
+    const std::size_t size = M_workers.size();
+    for (std::size_t i = 1; i < size; ++i) {
+      worker& victim = *M_workers[(id + i) % size];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task* t = victim.tasks.front();
+        victim.tasks.pop_front();
+        --M_queued;
+        return t;
+      }
+    }
+
+    return nullptr;
+  }
+
+  void detail::parallel_walker::process(worker& w, task& t) {
+    dir_reader dir(t.path);
+    if (!t.root && !dir.is_open()) {
+      return;
+    }
+
+    std::vector<fs::path>& found = M_ordered ? t.found : w.found;
+
+    for (const walk_state& s : t.states) {
+      if (M_rules.matches_self(s, t.path.empty(), dir.is_open())) {
+        found.push_back(t.path / fs::path());
+      }
+    }
+
+    const bool listing = M_rules.needs_listing(t.states);
+    for (const walk_state& s : t.states) {
+      const fs::path* name = M_rules.probe_name(s, listing);
+      if (name == nullptr) {
+        continue;
+      }
+
+      if (M_rules.is_last(s)) {
+        if (dir.exists(*name)) {
+          found.push_back(t.path / *name);
+        }
+      } else {
+        state_list states;
+        M_rules.add_state(states, {s.pattern, s.index + 1, true});
+        spawn(w, t, t.path / *name, std::move(states));
+      }
+    }
+
+    if (!listing) {
+      return;
+    }
+
+    dir_entry entry;
+    while (dir.next(entry)) {
+      // a single pattern matches at most once
+      M_rules.match_entry(t.states, entry.name, w.next, w.matched);
+      if (!w.matched.empty()) {
+        found.push_back(t.path / entry.name);
+      }
+
+      if (!w.next.empty() && dir.is_directory(entry)) {
+        spawn(w, t, t.path / entry.name, w.next);
+      }
+    }
+  }
+
+  void detail::parallel_walker::spawn(worker& w, task& parent, fs::path path,
+                                      state_list states) {
+    task* child;
+    if (M_ordered) {
+      auto owned = std::make_unique<task>(
+          task{std::move(path), std::move(states), false, {}, {}});
+      child = owned.get();
+      parent.children.emplace_back(parent.found.size(), std::move(owned));
+    } else {
+      child = new task{std::move(path), std::move(states), false, {}, {}};
+    }
+
+    // counted before it can be popped, so that the count never underflows
+    ++M_pending;
+    ++M_queued;
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.tasks.push_back(child);
+    }
+
+    if (M_sleeping > 0L) {
+      std::lock_guard<std::mutex> lock(M_idle_mutex);
+      M_idle.notify_one();
+    }
+  }
+
+  std::vector<fs::path> detail::parallel_walker::flatten(task& root) {
+    struct cursor {
+      task* t;
+      std::size_t found;
+      std::size_t child;
+    };
+
+    std::vector<fs::path> files;
+    std::vector<cursor> stack = {{&root, 0L, 0L}};
+
+    while (!stack.empty()) {
+      cursor& c = stack.back();
+      task& t = *c.t;
+
+      // results of a subdirectory follow the entry which led to it
+      if (c.child < t.children.size() &&
+          t.children[c.child].first <= c.found) {
+        task* child = t.children[c.child++].second.get();
+        stack.push_back({child, 0L, 0L});
+      } else if (c.found < t.found.size()) {
+        files.push_back(std::move(t.found[c.found++]));
+      } else {
+        stack.pop_back();
+      }
+    }
+
+    return files;
+  }
+}  // namespace cppglob
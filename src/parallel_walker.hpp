@@ -0,0 +1,117 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_PARALLEL_WALKER_HPP
+#define CPPGLOB_SRC_PARALLEL_WALKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "glob_walker.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief walk over the directories reachable by a pattern with a pool of
+     * threads
+     *
+     * Every directory is a task which is read by one thread. Subdirectories
+     * which can still lead to a match are pushed as new tasks onto the deque
+     * of the thread which found them. A thread takes its own tasks from the
+     * back, which keeps its walk depth-first, and steals from the front of
+     * the deques of other threads when it runs out of work, and sleeps until
+     * a task is pushed or the walk ends if there is none. Tasks only carry
+     * the path of the directory, so the number of open directories is
+     * bounded by the number of threads.
+     *
+     * In ordered mode every task keeps its results together with the
+     * positions of its subdirectories, and the tree of tasks is flattened in
+     * the order of a single-threaded walk at the end.
+     */
+    class CPPGLOB_LOCAL parallel_walker {
+     public:
+      parallel_walker(const compiled_pattern& pat, unsigned int threads,
+                      bool ordered);
+
+      parallel_walker(const parallel_walker&) = delete;
+      parallel_walker& operator=(const parallel_walker&) = delete;
+
+      ~parallel_walker();
+
+      std::vector<fs::path> run();
+
+     private:
+      struct task {
+        fs::path path;
+        state_list states;
+        bool root;
+
+        // results and subdirectories (ordered mode only)
+        std::vector<fs::path> found;
+        std::vector<std::pair<std::size_t, std::unique_ptr<task>>> children;
+      };
+
+      struct worker {
+        std::mutex mutex;
+        std::deque<task*> tasks;
+
+        // results (unordered mode only)
+        std::vector<fs::path> found;
+        state_list next;
+        index_list matched;
+      };
+
+      void work(std::size_t id);
+      task* pop(std::size_t id);
+      void wait_for_task();
+      void wake_all();
+      void process(worker& w, task& t);
+      void spawn(worker& w, task& parent, fs::path path,
+                 state_list states);
+      std::vector<fs::path> flatten(task& root);
+
+      const compiled_pattern& M_pattern;
+      walk_rules M_rules;
+      bool M_ordered;
+      std::vector<std::unique_ptr<worker>> M_workers;
+      std::atomic<std::size_t> M_pending;
+      std::atomic<bool> M_failed;
+
+      // tasks in the deques, and threads waiting for one
+      std::atomic<std::size_t> M_queued;
+      std::atomic<std::size_t> M_sleeping;
+      std::mutex M_idle_mutex;
+      std::condition_variable M_idle;
+
+      std::mutex M_error_mutex;
+      std::exception_ptr M_error;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <vector>
+#include <filesystem>
+#include <cppglob/path_list.hpp>
+
+namespace cppglob {
+  fs::path path_list::path(size_type i) const {
+    const string_view_type name = (*this)[i];
+    return fs::path(name.begin(), name.end());
+  }
+
+  void path_list::push_back(const string_view_type& pathname) {
+    const size_type length = M_buffer.size();
+    M_buffer.append(pathname.data(), pathname.size());
+    try {
+      M_ends.push_back(M_buffer.size());
+    } catch (...) {
+      M_buffer.resize(length);
+      throw;
+    }
+  }
+
+  void path_list::reserve(size_type count, size_type length) {
+    M_ends.reserve(count);
+    M_buffer.reserve(length);
+  }
+
+  void path_list::clear() noexcept {
+    M_ends.clear();
+    M_buffer.clear();
+  }
+
+  std::vector<fs::path> path_list::to_vector() const {
+    std::vector<fs::path> paths;
+    paths.reserve(size());
+    for (size_type i = 0; i < size(); ++i) {
+      paths.push_back(path(i));
+    }
+    return paths;
+  }
+}  // namespace cppglob
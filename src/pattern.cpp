@@ -0,0 +1,319 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <filesystem>
+#include <cppglob/pattern.hpp>
+#include "braces.hpp"
+#include "pattern_impl.hpp"
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE pattern_segment make_segment(const fs::path& name,
+                                                bool recursive,
+                                                pattern_flags flags) {
+      pattern_segment seg;
+      seg.name = name;
+      seg.hidden = !name.empty() && ishidden(name);
+
+      if (!has_magic(name, flags)) {
+        seg.kind = pattern_segment::literal;
+        if ((flags & pattern_flags::case_insensitive) != pattern_flags::none) {
+          // entries of a listing differ from the pattern in case
+          seg.icase = true;
+          seg.match = matcher(name.native(), flags);
+        }
+      } else if (recursive && isrecursive(name)) {
+        seg.kind = pattern_segment::recursive;
+      } else {
+        seg.kind = pattern_segment::magic;
+        seg.match = matcher(name.native(), flags);
+      }
+
+      return seg;
+    }
+
+    CPPGLOB_INLINE std::shared_ptr<compiled_pattern> compile_plain(
+        const fs::path& pathname, bool recursive, pattern_flags flags) {
+      auto pat = std::make_shared<compiled_pattern>();
+      pat->pathname = pathname;
+      pat->recursive = recursive;
+      pat->magic = has_magic(pathname, flags);
+      pat->flags = flags;
+
+      const string_type whole = pathname.lexically_normal().native();
+      pat->whole = matcher(whole, flags);
+
+      if (!pat->magic) {
+        pat->root = pathname;
+        return pat;
+      }
+
+      fs::path p = pathname;
+      while (true) {
+        fs::path dirname = p.parent_path();
+        pat->segments.push_back(
+            make_segment(p.filename(), recursive, flags));
+
+        if (dirname.empty()) {
+          break;
+        }
+        if (dirname != p && has_magic(dirname, flags)) {
+          p = std::move(dirname);
+          continue;
+        }
+
+        pat->root = std::move(dirname);
+        break;
+      }
+
+      std::reverse(pat->segments.begin(), pat->segments.end());
+      return pat;
+    }
+
+    /**
+     * @brief group the alternatives of a brace pattern by their root
+     *
+     * Alternatives with the same root path (e.g. all relative ones) form one
+     * group. The literal directories they have in common become the root of
+     * the group, and the remaining directories become literal segments which
+     * are looked up while walking, so that all files of "src/{core,net}"
+     * are found by reading "src" once. Every alternative keeps at least one
+     * segment.
+     */
+    CPPGLOB_INLINE void group_alternatives(
+        compiled_pattern& pat, const std::vector<string_type>& alternatives) {
+      struct walk {
+        std::size_t group;
+        std::vector<fs::path> names;  // literal directories of the root
+        std::vector<pattern_segment> segments;
+      };
+
+      std::vector<string_type> keys;
+      std::vector<walk> walks;
+
+      for (const string_type& alternative : alternatives) {
+        auto compiled =
+            compile_plain(fs::path(alternative), pat.recursive, pat.flags);
+        pat.alternatives.push_back(std::move(compiled->whole));
+
+        walk w;
+        for (const fs::path& name : compiled->root) {
+          w.names.push_back(name);
+        }
+        if (!compiled->magic && !compiled->root.has_relative_path()) {
+          // a root alone like "/" is matched as a trailing separator
+          w.names.emplace_back();
+        }
+        w.segments = std::move(compiled->segments);
+
+        const string_type key = compiled->root.root_path().native();
+        const auto it = std::find(keys.begin(), keys.end(), key);
+        w.group = static_cast<std::size_t>(it - keys.begin());
+        if (it == keys.end()) {
+          keys.push_back(key);
+        }
+        walks.push_back(std::move(w));
+      }
+
+      pat.groups.resize(keys.size());
+      for (std::size_t g = 0; g < keys.size(); ++g) {
+        const walk* first = nullptr;
+        std::size_t common = 0L;
+        for (const walk& w : walks) {
+          if (w.group != g) {
+            continue;
+          }
+
+          std::size_t limit = w.names.size() - (w.segments.empty() ? 1 : 0);
+          if (first == nullptr) {
+            first = &w;
+            common = limit;
+            continue;
+          }
+
+          limit = std::min(limit, common);
+          common = 0L;
+          while (common < limit &&
+                 w.names[common].native() == first->names[common].native()) {
+            ++common;
+          }
+        }
+
+        pattern_group& group = pat.groups[g];
+        for (std::size_t i = 0; i < common; ++i) {
+          group.root /= first->names[i];
+        }
+
+        for (walk& w : walks) {
+          if (w.group != g) {
+            continue;
+          }
+
+          std::vector<pattern_segment> segments;
+          for (std::size_t i = common; i < w.names.size(); ++i) {
+            segments.push_back(
+                make_segment(w.names[i], pat.recursive, pat.flags));
+          }
+          segments.insert(segments.end(),
+                          std::make_move_iterator(w.segments.begin()),
+                          std::make_move_iterator(w.segments.end()));
+          group.segments.push_back(std::move(segments));
+        }
+      }
+    }
+
+    CPPGLOB_INLINE std::shared_ptr<const compiled_pattern> compile(
+        const fs::path& pathname, bool recursive, pattern_flags flags) {
+      if ((flags & pattern_flags::braces) != pattern_flags::none) {
+        std::vector<string_type> expanded = expand_braces(pathname.native());
+        if (expanded.size() != 1 || expanded[0] != pathname.native()) {
+          // the same path is never returned twice, and an empty pattern
+          // matches nothing
+          std::vector<string_type> alternatives;
+          std::unordered_set<string_type> seen;
+          for (string_type& alternative : expanded) {
+            if (!alternative.empty() && seen.insert(alternative).second) {
+              alternatives.push_back(std::move(alternative));
+            }
+          }
+
+          auto pat = compile_plain(fs::path(), recursive, flags);
+          pat->pathname = pathname;
+          if (!alternatives.empty()) {
+            pat->magic = true;
+            group_alternatives(*pat, alternatives);
+          }
+          return pat;
+        }
+      }
+
+      return compile_plain(pathname, recursive, flags);
+    }
+  }  // namespace detail
+
+  pattern::pattern()
+      : M_impl(detail::compile(fs::path(), false, pattern_flags::none)) {}
+
+  pattern::pattern(const fs::path& pathname, bool recursive,
+                   pattern_flags flags)
+      : M_impl(detail::compile(pathname, recursive, flags)) {}
+
+  const fs::path& pattern::path() const noexcept { return M_impl->pathname; }
+
+  bool pattern::recursive() const noexcept { return M_impl->recursive; }
+
+  pattern_flags pattern::flags() const noexcept { return M_impl->flags; }
+
+  bool pattern::match(const fs::path& name) const {
+    if (M_impl->groups.empty()) {
+      return M_impl->whole.match_path(name);
+    }
+
+    for (const detail::matcher& m : M_impl->alternatives) {
+      if (m.match_path(name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  namespace detail {
+    /**
+     * @brief match every name of names against m (see pattern::match)
+     */
+    CPPGLOB_INLINE std::size_t match_list(const matcher& m,
+                                          const path_list& names,
+                                          std::vector<std::uint64_t>& bitmap) {
+      bitmap.resize((names.size() + 63) / 64);
+      std::size_t found = m.match_batch(names.buffer().data(),
+                                        names.ends().data(), names.size(),
+                                        bitmap.data());
+
+      // names with separators are not matched verbatim (see match_path)
+      const auto has_separator = [](const string_view_type& str) {
+        using traits = std::char_traits<char_type>;
+        const auto find = [&str](char_type c) {
+          return traits::find(str.data(), str.size(), c) != nullptr;
+        };
+#ifdef CPPGLOB_IS_WINDOWS
+        return find(L'\\') || find(L'/') || find(L':');
+#else
+        return find('/');
+#endif
+      };
+
+      if (!has_separator(names.buffer())) {
+        return found;
+      }
+
+      for (std::size_t i = 0; i < names.size(); ++i) {
+        if (!has_separator(names[i])) {
+          continue;
+        }
+
+        const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+        const bool matched = m.match_path(fs::path(names[i]));
+        if (matched != ((bitmap[i / 64] & bit) != 0)) {
+          bitmap[i / 64] ^= bit;
+          if (matched) {
+            ++found;
+          } else {
+            --found;
+          }
+        }
+      }
+
+      return found;
+    }
+  }  // namespace detail
+
+  std::size_t pattern::match(const path_list& names,
+                             std::vector<std::uint64_t>& bitmap) const {
+    if (M_impl->groups.empty()) {
+      return detail::match_list(M_impl->whole, names, bitmap);
+    }
+
+    bitmap.assign((names.size() + 63) / 64, 0);
+    std::vector<std::uint64_t> matched;
+    for (const detail::matcher& m : M_impl->alternatives) {
+      detail::match_list(m, names, matched);
+      for (std::size_t i = 0; i < bitmap.size(); ++i) {
+        bitmap[i] |= matched[i];
+      }
+    }
+
+    std::size_t found = 0L;
+    for (const std::uint64_t word : bitmap) {
+      found += std::bitset<64>(word).count();
+    }
+    return found;
+  }
+}  // namespace cppglob
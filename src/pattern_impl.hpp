@@ -0,0 +1,155 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_PATTERN_IMPL_HPP
+#define CPPGLOB_SRC_PATTERN_IMPL_HPP
+
+#include <memory>
+#include <vector>
+#include <cppglob/pattern.hpp>
+#include "case_fold.hpp"
+#include "extglob.hpp"
+#include "matcher.hpp"
+
+namespace cppglob {
+  namespace detail {
+    CPPGLOB_INLINE bool has_magic(const string_type& str) {
+      static const string_view_type magics = CStr("*?[");
+      for (const char_type& c : str) {
+        for (const char_type& magic : magics) {
+          if (c == magic) {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+#if defined(CPPGLOB_IS_WINDOWS) || defined(__APPLE__)
+    constexpr bool fs_ignores_case = true;
+#else
+    constexpr bool fs_ignores_case = false;
+#endif
+
+    /**
+     * @brief test whether str contains a character with case variants
+     */
+    CPPGLOB_INLINE bool has_cased(const string_type& str) {
+      char_type variants[max_case_variants];
+      for (const char_type& c : str) {
+        // multibyte characters are folded as a whole
+        if ((sizeof(char_type) == 1 && static_cast<unsigned char>(c) >= 0x80) ||
+            case_variants(c, variants) > 1) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    CPPGLOB_INLINE bool has_magic(const string_type& str, pattern_flags flags) {
+      // a case-insensitive name cannot be looked up directly if the file
+      // system distinguishes case
+      return has_magic(str) ||
+             ((flags & pattern_flags::extglob) != pattern_flags::none &&
+              has_extglob(str)) ||
+             (!fs_ignores_case &&
+              (flags & pattern_flags::case_insensitive) !=
+                  pattern_flags::none &&
+              has_cased(str));
+    }
+
+    CPPGLOB_INLINE bool ishidden(const fs::path& pathname) {
+      return pathname.native()[0] == '.';
+    }
+
+    CPPGLOB_INLINE bool isrecursive(const fs::path& pathname) {
+      return pathname.native() == CStr("**");
+    }
+
+    /**
+     * @brief single directory component of a compiled pattern
+     */
+    struct CPPGLOB_LOCAL pattern_segment {
+      enum kind_type : unsigned char { literal, magic, recursive };
+
+      kind_type kind;
+      fs::path name;
+      bool hidden;    // the component starts with a dot
+      matcher match;  // compiled name matcher (kind == magic, or icase)
+
+      // a literal component is compared with match instead of name
+      bool icase = false;
+    };
+
+    /**
+     * @brief alternatives of a brace pattern which are walked together
+     *
+     * The literal directories which the alternatives have in common form
+     * the root, and the rest of each alternative is split into segments, so
+     * that a directory reached by several alternatives is read only once.
+     */
+    struct CPPGLOB_LOCAL pattern_group {
+      fs::path root;
+      std::vector<std::vector<pattern_segment>> segments;
+    };
+
+    /**
+     * @brief data shared by all copies of a cppglob::pattern
+     *
+     * Magic patterns are decomposed exactly like the recursive dirname /
+     * basename split of glob(): the longest leading part without magic
+     * becomes the root which is used as is, and every remaining component
+     * is matched against the entries of the directories found so far.
+     */
+    struct CPPGLOB_LOCAL compiled_pattern {
+      fs::path pathname;
+      bool recursive = false;
+      bool magic = false;
+      pattern_flags flags = pattern_flags::none;
+
+      fs::path root;
+      std::vector<pattern_segment> segments;
+
+      // matcher for the whole normalized pathname (filter() semantics)
+      matcher whole;
+
+      // a pattern whose braces were expanded is walked by groups instead of
+      // root and segments, and matched by any of its alternatives
+      std::vector<pattern_group> groups;
+      std::vector<matcher> alternatives;
+    };
+
+    struct CPPGLOB_LOCAL pattern_access {
+      static const compiled_pattern& get(const pattern& pat) {
+        return *pat.M_impl;
+      }
+
+      static const std::shared_ptr<const compiled_pattern>& share(
+          const pattern& pat) {
+        return pat.M_impl;
+      }
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
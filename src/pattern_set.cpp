@@ -0,0 +1,231 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <filesystem>
+#include <cppglob/pattern.hpp>
+#include <cppglob/pattern_set.hpp>
+#include "matcher.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief node of an Aho-Corasick automaton (the root is node 0)
+     */
+    struct CPPGLOB_LOCAL ac_node {
+      // transitions of the trie, sorted by character
+      std::vector<std::pair<char_type, std::uint32_t>> next;
+
+      // longest proper suffix which is also a node
+      std::uint32_t fail = 0;
+
+      // nearest node on the failure chain with outputs (0 if none)
+      std::uint32_t output_link = 0;
+
+      // patterns whose literal ends at this node
+      std::vector<std::uint32_t> outputs;
+
+      // return the child for c, or 0 (the root is nobody's child)
+      std::uint32_t child(char_type c) const {
+        auto it = std::lower_bound(
+            next.begin(), next.end(), c,
+            [](const std::pair<char_type, std::uint32_t>& edge,
+               char_type ch) { return edge.first < ch; });
+        return it != next.end() && it->first == c ? it->second : 0;
+      }
+    };
+
+    struct CPPGLOB_LOCAL pattern_set_impl {
+      std::vector<fs::path> paths;
+      std::vector<matcher> matchers;
+      std::vector<ac_node> nodes{ac_node()};
+
+      // patterns without a required literal, which are always candidates
+      std::vector<std::uint32_t> always;
+
+      void insert(const string_type& lit, std::uint32_t id);
+      void link();
+
+      /**
+       * @brief call fn with the ID of every pattern whose literal occurs in
+       * name (several times if it occurs several times) until fn returns
+       * true
+       */
+      template <typename F>
+      bool scan(const string_view_type& name, F&& fn) const;
+    };
+
+    void pattern_set_impl::insert(const string_type& lit, std::uint32_t id) {
+      std::uint32_t node = 0;
+      for (char_type c : lit) {
+        std::uint32_t next = nodes[node].child(c);
+        if (next == 0) {
+          next = static_cast<std::uint32_t>(nodes.size());
+          auto& edges = nodes[node].next;
+          auto it = std::lower_bound(
+              edges.begin(), edges.end(), c,
+              [](const std::pair<char_type, std::uint32_t>& edge,
+                 char_type ch) { return edge.first < ch; });
+          edges.insert(it, {c, next});
+          nodes.emplace_back();
+        }
+        node = next;
+      }
+      nodes[node].outputs.push_back(id);
+    }
+
+    void pattern_set_impl::link() {
+      // breadth-first, so that the failure node of a node is always done
+      std::vector<std::uint32_t> queue;
+      for (auto& edge : nodes[0].next) {
+        queue.push_back(edge.second);
+      }
+
+      for (std::size_t i = 0; i < queue.size(); ++i) {
+        const std::uint32_t u = queue[i];
+        for (auto& edge : nodes[u].next) {
+          const std::uint32_t v = edge.second;
+          std::uint32_t f = nodes[u].fail;
+          while (f != 0 && nodes[f].child(edge.first) == 0) {
+            f = nodes[f].fail;
+          }
+          nodes[v].fail = nodes[f].child(edge.first);
+
+          const ac_node& fail = nodes[nodes[v].fail];
+          nodes[v].output_link =
+              fail.outputs.empty() ? fail.output_link : nodes[v].fail;
+          queue.push_back(v);
+        }
+      }
+    }
+
+    template <typename F>
+    bool pattern_set_impl::scan(const string_view_type& name, F&& fn) const {
+      std::uint32_t state = 0;
+      for (char_type c : name) {
+        std::uint32_t next;
+        while ((next = nodes[state].child(c)) == 0 && state != 0) {
+          state = nodes[state].fail;
+        }
+        state = next;
+
+        for (std::uint32_t node = state; node != 0;
+             node = nodes[node].output_link) {
+          for (std::uint32_t id : nodes[node].outputs) {
+            if (fn(id)) {
+              return true;
+            }
+          }
+        }
+      }
+      return false;
+    }
+  }  // namespace detail
+
+  pattern_set::pattern_set()
+      : M_impl(std::make_shared<detail::pattern_set_impl>()) {}
+
+  pattern_set::pattern_set(const std::vector<fs::path>& patterns) {
+    auto impl = std::make_shared<detail::pattern_set_impl>();
+    impl->paths = patterns;
+    impl->matchers.reserve(patterns.size());
+
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      const auto id = static_cast<std::uint32_t>(i);
+      impl->matchers.emplace_back(patterns[i].lexically_normal().native());
+
+      const string_type lit = impl->matchers.back().required_literal();
+      if (lit.empty()) {
+        impl->always.push_back(id);
+      } else {
+        impl->insert(lit, id);
+      }
+    }
+
+    impl->link();
+    M_impl = std::move(impl);
+  }
+
+  std::size_t pattern_set::size() const noexcept {
+    return M_impl->paths.size();
+  }
+
+  const fs::path& pattern_set::path(std::size_t id) const {
+    return M_impl->paths.at(id);
+  }
+
+  std::vector<std::size_t> pattern_set::matches(const fs::path& name) const {
+    std::vector<std::size_t> ids;
+    matches(name, ids);
+    return ids;
+  }
+
+  void pattern_set::matches(const fs::path& name,
+                            std::vector<std::size_t>& ids) const {
+    const detail::pattern_set_impl& impl = *M_impl;
+    ids.clear();
+
+    string_type normal;
+    string_view_type str = name.native();
+    if (!detail::is_normal(str)) {
+      normal = name.lexically_normal().native();
+      str = normal;
+    }
+
+    // a literal may occur several times in the name
+    impl.scan(str, [&ids](std::uint32_t id) {
+      ids.push_back(id);
+      return false;
+    });
+    ids.insert(ids.end(), impl.always.begin(), impl.always.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+                             [&impl, &str](std::size_t id) {
+                               return !impl.matchers[id].match(str);
+                             }),
+              ids.end());
+  }
+
+  bool pattern_set::match_any(const fs::path& name) const {
+    const detail::pattern_set_impl& impl = *M_impl;
+
+    string_type normal;
+    string_view_type str = name.native();
+    if (!detail::is_normal(str)) {
+      normal = name.lexically_normal().native();
+      str = normal;
+    }
+
+    const auto confirm = [&impl, &str](std::uint32_t id) {
+      return impl.matchers[id].match(str);
+    };
+    return std::any_of(impl.always.begin(), impl.always.end(), confirm) ||
+           impl.scan(str, confirm);
+  }
+}  // namespace cppglob
@@ -0,0 +1,65 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "shift_and.hpp"
+
+namespace cppglob {
+  detail::shift_and::shift_and(const std::vector<pattern_token>& tokens,
+                               const std::vector<char_class>& classes,
+                               const std::vector<std::size_t>& bounds)
+      : M_words(tokens.size() < 64 ? 1L : 2L),
+        M_final(tokens.size()),
+        M_tokens(tokens),
+        M_classes(classes) {
+    // every star but the virtual one at the end is a self-loop
+    for (std::size_t k = 0; k + 1 < bounds.size(); ++k) {
+      M_loops[bounds[k] / 64] |= word(1) << (bounds[k] % 64);
+    }
+
+    using uchar = std::make_unsigned_t<char_type>;
+    M_table.assign(256 * M_words, 0);
+    for (unsigned int u = 0; u < 256; ++u) {
+      const auto c = static_cast<char_type>(static_cast<uchar>(u));
+      for (std::size_t p = 0; p < M_final; ++p) {
+        if (token_matches(p, c)) {
+          M_table[u * M_words + p / 64] |= word(1) << (p % 64);
+        }
+      }
+    }
+  }
+
+  bool detail::shift_and::token_matches(std::size_t i,
+                                        char_type c) const noexcept {
+    const pattern_token& tok = M_tokens[i];
+    switch (tok.kind) {
+      case pattern_token::literal:
+        return tok.ch == c;
+      case pattern_token::bracket:
+        return M_classes[tok.index].contains(c);
+      default:
+        return true;
+    }
+  }
+}  // namespace cppglob
@@ -0,0 +1,114 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_SHIFT_AND_HPP
+#define CPPGLOB_SRC_SHIFT_AND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "matcher.hpp"
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief bit-parallel simulation of the position automaton of a
+     * pattern (Shift-And)
+     *
+     * Every position between two tokens is one bit of one or two machine
+     * words. For every character, the positions whose token accepts it
+     * move to the next position with a shift, and the positions after a
+     * star keep their bit. Matching is a fixed number of word operations
+     * per character, without branches on the pattern and without any
+     * allocation. Masks of narrow characters are precomputed; those of
+     * wider characters are computed from the tokens.
+     */
+    class CPPGLOB_LOCAL shift_and {
+     public:
+      // positions are tokens + 1
+      static constexpr std::size_t max_tokens = 127;
+
+      shift_and(const std::vector<pattern_token>& tokens,
+                const std::vector<char_class>& classes,
+                const std::vector<std::size_t>& bounds);
+
+      bool match(const string_view_type& name) const noexcept {
+        return M_words == 1 ? run<1>(name) : run<2>(name);
+      }
+
+     private:
+      using word = std::uint64_t;
+
+      template <std::size_t Words>
+      bool run(const string_view_type& name) const noexcept;
+
+      bool token_matches(std::size_t i, char_type c) const noexcept;
+
+      std::size_t M_words;
+      std::size_t M_final;  // position after the last token
+
+      std::vector<word> M_table;  // M_words words per narrow character
+      word M_loops[2] = {};       // positions following a star
+
+      // tokens are kept for characters above 255
+      std::vector<pattern_token> M_tokens;
+      std::vector<char_class> M_classes;
+    };
+
+    template <std::size_t Words>
+    bool shift_and::run(const string_view_type& name) const noexcept {
+      word state[Words] = {1};
+
+      for (char_type c : name) {
+        word wide[Words] = {};
+        const word* mask = wide;
+        if (is_narrow(c)) {
+          const auto u = static_cast<std::make_unsigned_t<char_type>>(c);
+          mask = &M_table[u * Words];
+        } else {
+          for (std::size_t p = 0; p < M_final; ++p) {
+            if (token_matches(p, c)) {
+              wide[p / 64] |= word(1) << (p % 64);
+            }
+          }
+        }
+
+        word carry = 0, alive = 0;
+        for (std::size_t k = 0; k < Words; ++k) {
+          const word moved = state[k] & mask[k];
+          state[k] = (moved << 1) | carry | (state[k] & M_loops[k]);
+          carry = moved >> 63;
+          alive |= state[k];
+        }
+
+        if (alive == 0) {
+          return false;
+        }
+      }
+
+      return ((state[M_final / 64] >> (M_final % 64)) & 1) != 0;
+    }
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
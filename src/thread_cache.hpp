@@ -0,0 +1,98 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CPPGLOB_SRC_THREAD_CACHE_HPP
+#define CPPGLOB_SRC_THREAD_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <cppglob/config.hpp>
+
+namespace cppglob {
+  namespace detail {
+    /**
+     * @brief mutable state of a shared object, kept separately by every
+     * thread
+     *
+     * Matchers are shared by all threads which glob with the same pattern,
+     * while the automata they build on demand are written by every match.
+     * Instead of locking, every thread keeps its own State for each owner,
+     * copied from the initial state of the owner on first use, so that
+     * threads never wait for each other. States are identified by a serial
+     * number, because a later owner may be allocated at the same address. A
+     * thread keeps the states of at most Capacity owners and starts over
+     * when it needs more, which also drops the states of destroyed owners.
+     */
+    template <typename State, std::size_t Capacity = 64>
+    class CPPGLOB_LOCAL thread_cache {
+     public:
+      thread_cache() : M_serial(next_serial()) {}
+
+      /**
+       * @brief return the state of the calling thread, copying initial if
+       * the thread has none yet
+       */
+      State& get(const State& initial) const {
+        local_states& local = states();
+        if (local.last_serial == M_serial) {
+          return *local.last;
+        }
+
+        auto it = local.states.find(M_serial);
+        if (it == local.states.end()) {
+          if (local.states.size() >= Capacity) {
+            local.states.clear();
+          }
+          it = local.states.emplace(M_serial, initial).first;
+        }
+
+        local.last_serial = M_serial;
+        local.last = &it->second;
+        return it->second;
+      }
+
+     private:
+      struct local_states {
+        std::unordered_map<std::uint64_t, State> states;
+        std::uint64_t last_serial = 0L;  // serials start at 1
+        State* last = nullptr;
+      };
+
+      static local_states& states() {
+        thread_local local_states local;
+        return local;
+      }
+
+      static std::uint64_t next_serial() {
+        static std::atomic<std::uint64_t> serial(0L);
+        return ++serial;
+      }
+
+      std::uint64_t M_serial;
+    };
+  }  // namespace detail
+}  // namespace cppglob
+
+#endif
@@ -0,0 +1,707 @@
+/*
+ * copyright: 2018 Ryohei Machida
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cppglob/watched_glob.hpp>
+
+#ifdef CPPGLOB_HAS_WATCHED_GLOB
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <filesystem>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "dir_reader.hpp"
+#include "glob_walker.hpp"
+#include "pattern_impl.hpp"
+
+namespace cppglob {
+  namespace detail {
+    constexpr std::uint32_t watch_mask = IN_CREATE | IN_DELETE |
+                                         IN_MOVED_FROM | IN_MOVED_TO |
+                                         IN_DELETE_SELF | IN_MOVE_SELF |
+                                         IN_ONLYDIR;
+
+    [[noreturn]] CPPGLOB_INLINE void throw_errno(const char* what) {
+      throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    CPPGLOB_INLINE bool has_prefix(const string_type& str,
+                                   const string_type& prefix) {
+      return str.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    /**
+     * @brief results of a watched_glob and the directories they depend on
+     *
+     * Every watched directory is a node which keeps the walk states it was
+     * entered with, so that a name reported by an event is matched exactly
+     * like an entry read by the walker. Nodes are keyed by the group of the
+     * pattern and their path. Like the results they are kept ordered, so
+     * that everything below a directory is a contiguous range. A directory
+     * reached through several paths (symbolic links, or several groups) has
+     * a single watch descriptor which is shared by its nodes.
+     *
+     * A root which is missing, or which is removed later, is waited for in
+     * its nearest existing ancestor. That directory is watched by a node
+     * without states, and the root is walked again as soon as a directory
+     * on the way to it is created.
+     */
+    class CPPGLOB_LOCAL watched_glob_impl {
+     public:
+      explicit watched_glob_impl(std::shared_ptr<const compiled_pattern> pat);
+
+      watched_glob_impl(const watched_glob_impl&) = delete;
+      watched_glob_impl& operator=(const watched_glob_impl&) = delete;
+
+      ~watched_glob_impl() { ::close(M_fd); }
+
+      bool poll(int timeout_ms);
+
+      const std::vector<fs::path>& added() const noexcept {
+        return M_added_list;
+      }
+
+      const std::vector<fs::path>& removed() const noexcept {
+        return M_removed_list;
+      }
+
+      const std::set<string_type>& results() const noexcept {
+        return M_results;
+      }
+
+      int fd() const noexcept { return M_fd; }
+
+     private:
+      using node_key = std::pair<std::size_t, string_type>;
+
+      struct node {
+        state_list states;
+        int wd;
+        bool root;
+        bool ancestor;  // only waits for the root of its group
+      };
+
+      struct root_walk {
+        root_walk(fs::path root, walk_rules root_rules)
+            : path(std::move(root)), rules(std::move(root_rules)) {}
+
+        fs::path path;
+        walk_rules rules;
+        string_type ancestor;  // watched while the root is missing
+        bool waiting = false;
+      };
+
+      void scan_all();
+      void scan(std::size_t group, string_type path, state_list states,
+                bool root);
+      void rescan();
+
+      /**
+       * @brief walk the root of a group if it exists, or wait for it
+       */
+      void revive_root(std::size_t group);
+
+      /**
+       * @brief watch the nearest existing ancestor of the root of a group
+       * @param child receives the missing directory below the ancestor
+       * @return false if no ancestor can be watched
+       */
+      bool watch_ancestor(std::size_t group, string_type& child);
+      void unwatch_ancestor(std::size_t group);
+
+      /**
+       * @brief test whether name in the ancestor key is on the way to the
+       * root of its group
+       */
+      bool leads_to_root(const node_key& key,
+                         const string_view_type& name) const;
+
+      void handle(const inotify_event& event);
+      void add_entry(const node_key& key, const string_view_type& name);
+      void remove_entry(const node_key& key, const string_view_type& name);
+
+      /**
+       * @brief forget the directory path of a group, its subdirectories and
+       * all results below it
+       */
+      void remove_tree(std::size_t group, const string_type& path);
+      void unwatch(const node_key& key, int wd);
+
+      void add_result(const string_type& path);
+      void note_removed(const string_type& path);
+
+      std::shared_ptr<const compiled_pattern> M_pattern;
+      std::vector<pattern_segment> M_literal;  // pattern without magic
+      std::vector<root_walk> M_roots;
+      int M_fd;
+
+      std::map<node_key, node> M_nodes;
+      std::unordered_map<int, std::vector<node_key>> M_watches;
+      std::set<string_type> M_results;
+
+      // changes during the current poll()
+      std::set<string_type> M_added;
+      std::set<string_type> M_removed;
+      std::vector<fs::path> M_added_list;
+      std::vector<fs::path> M_removed_list;
+
+      state_list M_next;
+      index_list M_matched;
+    };
+
+    watched_glob_impl::watched_glob_impl(
+        std::shared_ptr<const compiled_pattern> pat)
+        : M_pattern(std::move(pat)) {
+      const compiled_pattern& compiled = *M_pattern;
+
+      if (!compiled.groups.empty()) {
+        for (const pattern_group& group : compiled.groups) {
+          walk_rules rules;
+          for (const auto& segments : group.segments) {
+            rules.add_pattern(segments);
+          }
+          M_roots.emplace_back(group.root, std::move(rules));
+        }
+      } else if (compiled.magic) {
+        M_roots.emplace_back(compiled.root, walk_rules(compiled));
+      } else {
+        // a pattern without magic is a literal name in its parent, so that
+        // it is found when it is created
+        pattern_segment seg;
+        seg.kind = pattern_segment::literal;
+        seg.name = compiled.pathname.filename();
+        seg.hidden = !seg.name.empty() && ishidden(seg.name);
+        M_literal.push_back(std::move(seg));
+
+        walk_rules rules;
+        rules.add_pattern(M_literal);
+        M_roots.emplace_back(compiled.pathname.parent_path(), std::move(rules));
+      }
+
+      M_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if (M_fd < 0) {
+        throw_errno("inotify_init1");
+      }
+
+      try {
+        scan_all();
+      } catch (...) {
+        ::close(M_fd);
+        throw;
+      }
+
+      // the results of the first walk are not changes
+      M_added.clear();
+    }
+
+    void watched_glob_impl::scan_all() {
+      for (std::size_t group = 0; group < M_roots.size(); ++group) {
+        revive_root(group);
+      }
+    }
+
+    void watched_glob_impl::revive_root(std::size_t group) {
+      unwatch_ancestor(group);
+
+      const walk_rules& rules = M_roots[group].rules;
+      const string_type& root = M_roots[group].path.native();
+      const node_key key(group, root);
+      std::size_t progress = 0L;
+
+      while (M_nodes.count(key) == 0) {
+        scan(group, root, rules.initial_states(), true);
+        if (M_nodes.count(key) != 0) {
+          return;
+        }
+
+        // a directory created before the ancestor was watched would never
+        // be reported, so it is checked again afterwards. Every retry has
+        // to get closer to the root.
+        string_type child;
+        if (!watch_ancestor(group, child)) {
+          return;
+        }
+        std::error_code ec;
+        if (child.size() <= progress || !fs::is_directory(child, ec)) {
+          return;
+        }
+        progress = child.size();
+        unwatch_ancestor(group);
+      }
+    }
+
+    bool watched_glob_impl::watch_ancestor(std::size_t group,
+                                           string_type& child) {
+      root_walk& walk = M_roots[group];
+      fs::path path = walk.path;
+      if (!path.has_filename()) {
+        path = path.parent_path();  // "a/" is the directory "a"
+      }
+
+      while (true) {
+        fs::path parent = path.parent_path();
+        if (parent == path) {
+          return false;
+        }
+
+        const int wd = inotify_add_watch(
+            M_fd, parent.empty() ? "." : parent.c_str(), watch_mask);
+        if (wd >= 0) {
+          node_key key(group, parent.native());
+          M_watches[wd].push_back(key);
+          M_nodes.emplace(key, node{state_list(), wd, false, true});
+          walk.ancestor = std::move(key.second);
+          walk.waiting = true;
+          child = path.native();
+          return true;
+        }
+        if (errno == ENOSPC || errno == ENOMEM) {
+          throw_errno("inotify_add_watch");
+        }
+        if (parent.empty()) {
+          return false;
+        }
+        path = std::move(parent);
+      }
+    }
+
+    void watched_glob_impl::unwatch_ancestor(std::size_t group) {
+      root_walk& walk = M_roots[group];
+      if (!walk.waiting) {
+        return;
+      }
+
+      walk.waiting = false;
+      const auto it = M_nodes.find(node_key(group, walk.ancestor));
+      if (it != M_nodes.end()) {
+        unwatch(it->first, it->second.wd);
+        M_nodes.erase(it);
+      }
+    }
+
+    bool watched_glob_impl::leads_to_root(const node_key& key,
+                                          const string_view_type& name) const {
+      string_type candidate = key.second;
+      append_name(candidate, name);
+      append_name(candidate, string_view_type());
+      string_type root = M_roots[key.first].path.native();
+      append_name(root, string_view_type());
+      return has_prefix(root, candidate);
+    }
+
+    void watched_glob_impl::scan(std::size_t group, string_type path,
+                                 state_list states, bool root) {
+      struct pending {
+        string_type path;
+        state_list states;
+      };
+
+      const walk_rules& rules = M_roots[group].rules;
+      std::vector<pending> stack;
+      stack.push_back({std::move(path), std::move(states)});
+
+      while (!stack.empty()) {
+        node_key key(group, std::move(stack.back().path));
+        state_list dir_states = std::move(stack.back().states);
+        stack.pop_back();
+
+        if (M_nodes.count(key) != 0) {
+          continue;
+        }
+
+        // the watch is added before the directory is read, so that an entry
+        // created in between is reported by both (results are a set)
+        const string_type& dirname = key.second;
+        const int wd = inotify_add_watch(
+            M_fd, dirname.empty() ? "." : dirname.c_str(), watch_mask);
+        if (wd < 0) {
+          if (errno == ENOSPC || errno == ENOMEM) {
+            throw_errno("inotify_add_watch");
+          }
+          // removed already, not a directory or not readable
+          continue;
+        }
+
+        dir_reader dir{fs::path(dirname)};
+        auto it = M_nodes
+                      .emplace(std::move(key),
+                               node{std::move(dir_states), wd, root, false})
+                      .first;
+        M_watches[wd].push_back(it->first);
+        root = false;
+
+        const string_type& dir_path = it->first.second;
+        const state_list& current = it->second.states;
+        for (const walk_state& s : current) {
+          if (rules.matches_self(s, dir_path.empty(), dir.is_open())) {
+            string_type result = dir_path;
+            append_name(result, string_view_type());
+            add_result(result);
+            break;
+          }
+        }
+
+        const bool listing = rules.needs_listing(current);
+        const auto same_probe = [&](std::size_t i, const fs::path& name,
+                                    bool last) {
+          const fs::path* other = rules.probe_name(current[i], listing);
+          return other != nullptr && other->native() == name.native() &&
+                 rules.is_last(current[i]) == last;
+        };
+
+        for (std::size_t pos = 0; pos < current.size(); ++pos) {
+          const fs::path* name = rules.probe_name(current[pos], listing);
+          if (name == nullptr) {
+            continue;
+          }
+
+          const bool last = rules.is_last(current[pos]);
+          bool probed = false;
+          for (std::size_t i = 0; i < pos && !probed; ++i) {
+            probed = same_probe(i, *name, last);
+          }
+          if (probed) {
+            continue;
+          }
+
+          string_type child = dir_path;
+          append_name(child, name->native());
+          if (last) {
+            if (dir.exists(*name)) {
+              add_result(child);
+            }
+            continue;
+          }
+
+          state_list next;
+          for (std::size_t i = pos; i < current.size(); ++i) {
+            if (same_probe(i, *name, false)) {
+              const walk_state& s = current[i];
+              rules.add_state(next, {s.pattern, s.index + 1, true});
+            }
+          }
+          stack.push_back({std::move(child), std::move(next)});
+        }
+
+        if (!listing) {
+          continue;
+        }
+
+        dir_entry entry;
+        while (dir.next(entry)) {
+          rules.match_entry(current, entry.name, M_next, M_matched);
+          if (M_matched.empty() && M_next.empty()) {
+            continue;
+          }
+
+          string_type child = dir_path;
+          append_name(child, entry.name);
+          if (!M_matched.empty()) {
+            add_result(child);
+          }
+          if (!M_next.empty() && dir.is_directory(entry)) {
+            stack.push_back({std::move(child), M_next});
+          }
+        }
+      }
+    }
+
+    void watched_glob_impl::rescan() {
+      // results as they were when poll() was called
+      std::set<string_type> before = M_results;
+      for (const string_type& path : M_added) {
+        before.erase(path);
+      }
+      before.insert(M_removed.begin(), M_removed.end());
+
+      for (const auto& watch : M_watches) {
+        inotify_rm_watch(M_fd, watch.first);
+      }
+      M_watches.clear();
+      M_nodes.clear();
+      M_results.clear();
+      for (root_walk& walk : M_roots) {
+        walk.waiting = false;
+      }
+
+      scan_all();
+
+      M_added.clear();
+      M_removed.clear();
+      std::set_difference(M_results.begin(), M_results.end(), before.begin(),
+                          before.end(),
+                          std::inserter(M_added, M_added.end()));
+      std::set_difference(before.begin(), before.end(), M_results.begin(),
+                          M_results.end(),
+                          std::inserter(M_removed, M_removed.end()));
+    }
+
+    bool watched_glob_impl::poll(int timeout_ms) {
+      M_added.clear();
+      M_removed.clear();
+
+      pollfd p{M_fd, POLLIN, 0};
+      int ready;
+      while ((ready = ::poll(&p, 1, timeout_ms)) < 0) {
+        if (errno != EINTR) {
+          throw_errno("poll");
+        }
+      }
+
+      bool overflow = false;
+      while (ready > 0) {
+        alignas(inotify_event) char buffer[16384];
+        const ssize_t size = ::read(M_fd, buffer, sizeof(buffer));
+        if (size < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          if (errno == EAGAIN) {
+            break;
+          }
+          throw_errno("read");
+        }
+
+        for (ssize_t pos = 0; pos < size;) {
+          const auto* event = reinterpret_cast<inotify_event*>(buffer + pos);
+          pos += sizeof(inotify_event) + event->len;
+
+          // after an overflow the tree is walked again anyway
+          if ((event->mask & IN_Q_OVERFLOW) != 0) {
+            overflow = true;
+          } else if (!overflow) {
+            handle(*event);
+          }
+        }
+      }
+
+      if (overflow) {
+        rescan();
+      }
+
+      M_added_list.assign(M_added.begin(), M_added.end());
+      M_removed_list.assign(M_removed.begin(), M_removed.end());
+      return !M_added.empty() || !M_removed.empty();
+    }
+
+    void watched_glob_impl::handle(const inotify_event& event) {
+      const auto watch = M_watches.find(event.wd);
+      if (watch == M_watches.end()) {
+        return;
+      }
+
+      // the handlers change the nodes of the watch
+      const std::vector<node_key> keys = watch->second;
+
+      if ((event.mask & (IN_DELETE_SELF | IN_IGNORED | IN_MOVE_SELF)) != 0) {
+        const bool moved = (event.mask & IN_MOVE_SELF) != 0;
+        for (const node_key& key : keys) {
+          const auto it = M_nodes.find(key);
+          if (it == M_nodes.end()) {
+            continue;
+          }
+
+          // a renamed subdirectory is removed by the event of its parent,
+          // which may have been handled already, but nothing reports the
+          // rename of a root or of the ancestor it is waited for in
+          const node& n = it->second;
+          if (n.ancestor) {
+            revive_root(key.first);
+          } else if (n.root && !(moved && key.second.empty())) {
+            remove_tree(key.first, key.second);
+            revive_root(key.first);
+          } else if (!moved) {
+            remove_tree(key.first, key.second);
+          }
+        }
+        return;
+      }
+
+      if (event.len == 0) {
+        return;
+      }
+
+      const string_view_type name(event.name);
+      for (const node_key& key : keys) {
+        const auto it = M_nodes.find(key);
+        if (it != M_nodes.end() && it->second.ancestor) {
+          if ((event.mask & (IN_CREATE | IN_MOVED_TO)) != 0 &&
+              leads_to_root(key, name)) {
+            revive_root(key.first);
+          }
+          continue;
+        }
+
+        // an entry which replaces another one by a rename may be a
+        // different directory
+        if ((event.mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) != 0) {
+          remove_entry(key, name);
+        }
+        if ((event.mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+          add_entry(key, name);
+        }
+      }
+    }
+
+    void watched_glob_impl::add_entry(const node_key& key,
+                                      const string_view_type& name) {
+      const auto it = M_nodes.find(key);
+      if (it == M_nodes.end()) {
+        return;
+      }
+
+      M_roots[key.first].rules.match_entry(it->second.states, name, M_next,
+                                           M_matched);
+      if (M_matched.empty() && M_next.empty()) {
+        return;
+      }
+
+      string_type path = key.second;
+      append_name(path, name);
+      if (!M_matched.empty()) {
+        add_result(path);
+      }
+
+      std::error_code ec;
+      if (!M_next.empty() && fs::is_directory(path, ec)) {
+        scan(key.first, std::move(path), M_next, false);
+      }
+    }
+
+    void watched_glob_impl::remove_entry(const node_key& key,
+                                         const string_view_type& name) {
+      if (M_nodes.count(key) == 0) {
+        return;
+      }
+
+      string_type path = key.second;
+      append_name(path, name);
+      if (M_results.erase(path) != 0) {
+        note_removed(path);
+      }
+      remove_tree(key.first, path);
+    }
+
+    void watched_glob_impl::remove_tree(std::size_t group,
+                                        const string_type& path) {
+      string_type prefix = path;
+      append_name(prefix, string_view_type());
+
+      auto it = M_nodes.find(node_key(group, path));
+      if (it != M_nodes.end()) {
+        unwatch(it->first, it->second.wd);
+        M_nodes.erase(it);
+      }
+
+      // "a/b-c" sorts between "a/b" and "a/b/c", so only the names with
+      // the prefix "a/b/" are contiguous
+      it = M_nodes.lower_bound(node_key(group, prefix));
+      while (it != M_nodes.end() && it->first.first == group &&
+             has_prefix(it->first.second, prefix)) {
+        unwatch(it->first, it->second.wd);
+        it = M_nodes.erase(it);
+      }
+
+      auto result = M_results.lower_bound(prefix);
+      while (result != M_results.end() && has_prefix(*result, prefix)) {
+        note_removed(*result);
+        result = M_results.erase(result);
+      }
+    }
+
+    void watched_glob_impl::unwatch(const node_key& key, int wd) {
+      const auto watch = M_watches.find(wd);
+      if (watch == M_watches.end()) {
+        return;
+      }
+
+      std::vector<node_key>& keys = watch->second;
+      keys.erase(std::find(keys.begin(), keys.end(), key));
+      if (keys.empty()) {
+        // fails harmlessly if the directory has been removed already
+        inotify_rm_watch(M_fd, wd);
+        M_watches.erase(watch);
+      }
+    }
+
+    void watched_glob_impl::add_result(const string_type& path) {
+      // the current directory matched by '**' is not a result (see
+      // remove_recursive_root)
+      if (path.empty() || !M_results.insert(path).second) {
+        return;
+      }
+      if (M_removed.erase(path) == 0) {
+        M_added.insert(path);
+      }
+    }
+
+    void watched_glob_impl::note_removed(const string_type& path) {
+      if (M_added.erase(path) == 0) {
+        M_removed.insert(path);
+      }
+    }
+  }  // namespace detail
+
+  watched_glob::watched_glob(const pattern& pat)
+      : M_impl(std::make_unique<detail::watched_glob_impl>(
+            detail::pattern_access::share(pat))) {}
+
+  watched_glob::watched_glob(watched_glob&& other) noexcept = default;
+  watched_glob& watched_glob::operator=(watched_glob&& other) noexcept =
+      default;
+  watched_glob::~watched_glob() = default;
+
+  bool watched_glob::poll(int timeout_ms) { return M_impl->poll(timeout_ms); }
+
+  const std::vector<fs::path>& watched_glob::added() const noexcept {
+    return M_impl->added();
+  }
+
+  const std::vector<fs::path>& watched_glob::removed() const noexcept {
+    return M_impl->removed();
+  }
+
+  std::vector<fs::path> watched_glob::snapshot() const {
+    const std::set<string_type>& results = M_impl->results();
+    return std::vector<fs::path>(results.begin(), results.end());
+  }
+
+  std::size_t watched_glob::size() const noexcept {
+    return M_impl->results().size();
+  }
+
+  int watched_glob::native_handle() const noexcept { return M_impl->fd(); }
+}  // namespace cppglob
+
+#endif
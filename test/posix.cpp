@@ -8,13 +8,19 @@
 
 #include <cstdio>
 #include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <regex>
 #include <string_view>
 #include <stdexcept>
+#include <thread>
 #include <filesystem>
 
 #include <cppglob/fnmatch.hpp>
 #include <cppglob/glob.hpp>
 #include <cppglob/iglob.hpp>
+#include <cppglob/static_pattern.hpp>
+#include <cppglob/watched_glob.hpp>
 #include "doctest.h"
 
 namespace fs = std::filesystem;
@@ -105,6 +111,41 @@ TEST_CASE("filter() function") {
   CHECK_EQ(names[1], fs::path("./a/../a/b"));
 }
 
+TEST_CASE("filter() agrees with translate()") {
+  const std::vector<std::string> patterns = {
+      "*",     "*.txt",  "a*",    "*a*",    "?",      "??.c",
+      "a*b*c", "*a*a*b", "[ab]*", "[!ab]*", "[a-c]?", "[-a]*",
+      "[a-]*", "*[0-9]", "a[",    "a\\b",  "*.*.*",  "abc",
+      "x*y*z*", "[*]",   "[?]a",  "*[!.]", "a*c",    "*b*",
+      "a**c",   "**a",   "*.c*",  "x*",     "[a-f0-9][a-f0-9]*",
+      "[!a-c]*", "*ab*ab*", "*a?b*[0-9]c*", "x*[ab][ab]*z"};
+  const std::vector<std::string> names = {
+      "",     "a",     "b",      "ab",   "abc",   "aXbYc", "aab",   "ba",
+      "c1",   "]x",    "-",      "a-",   "x.txt", "x.y.z", "a[",    "a\\b",
+      "xyz",  "xaybzc", "*",     "?a",   "file9", "aaaab", ".",     "ab.c",
+      "3f",   "0a1",   "9g"};
+
+  for (auto&& pat : patterns) {
+    std::regex re(cppglob::translate(pat));
+    for (auto&& name : names) {
+      std::vector<fs::path> vec = {name};
+      cppglob::filter(vec, pat);
+      CHECK_MESSAGE(vec.size() == (std::regex_match(name, re) ? 1L : 0L),
+                    "pattern: " << pat << ", name: " << name);
+    }
+  }
+
+  // a leading ']' is a member of the set (ECMAScript regex reads "[]" as an
+  // empty class instead)
+  std::vector<fs::path> vec = {"]x", "a", "x]"};
+  cppglob::filter(vec, "[]]*");
+  unorderd_compare_results(vec, {"]x"});
+
+  vec = {"]x", "a", "x]"};
+  cppglob::filter(vec, "[!]]*");
+  unorderd_compare_results(vec, {"a", "x]"});
+}
+
 TEST_CASE("iglob() function") {
   test_in_dir _;
 
@@ -127,6 +168,66 @@ TEST_CASE("iglob() function") {
       vec, {"apple", "banana", "apple/apple.txt", "banana/apple.txt"});
 }
 
+TEST_CASE("lazy iglob()") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a"));
+  create_file("a/1.txt");
+  create_file("a/2.txt");
+  create_file("a/3.txt");
+
+  cppglob::glob_iterator it = cppglob::iglob("a/*.txt"), end;
+  REQUIRE_NE(it, end);
+  const fs::path first = *it;
+
+  // copies share the same walk
+  cppglob::glob_iterator copied = it;
+  ++copied;
+  REQUIRE_NE(copied, end);
+  CHECK_NE(*copied, first);
+  CHECK_EQ(*it, first);
+
+  std::vector<fs::path> rest(copied, end);
+  CHECK_EQ(rest.size(), 2);
+  CHECK_EQ(++it, end);
+
+  CHECK_EQ(cppglob::iglob("b/*/*.txt"), end);
+}
+
+TEST_CASE("linear time matching") {
+  // every star would be retried at every position by a backtracking matcher
+  const std::string name(20000, 'a');
+  std::vector<fs::path> names{name, name + "b"};
+  cppglob::filter(names, "*a*a*a*a*a*a*b");
+  unorderd_compare_results(names, {name + "b"});
+
+  names = {name, name + "b", "x" + name + "ab"};
+  cppglob::filter(names, "*aaaaaaaaaaab*");
+  unorderd_compare_results(names, {name + "b", "x" + name + "ab"});
+
+  names = {name, name + "ba", "a" + name};
+  cppglob::filter(names, "a*[ab]a[ab]a*?a");
+  unorderd_compare_results(names, {name, name + "ba", "a" + name});
+  // middle segments of 90 and 150 tokens
+  for (std::size_t len : {90, 150}) {
+    std::string pat = "x*";
+    for (std::size_t i = 0; i < len; ++i) {
+      pat += "[ab]";
+    }
+    pat += "*y";
+
+    std::string ab;
+    for (std::size_t i = 0; i < len; ++i) {
+      ab += i % 3 ? 'a' : 'b';
+    }
+    names = {"x" + ab + "y", "xx" + ab + "yy", "x" + ab.substr(1) + "y",
+             "x" + ab + "cy"};
+    cppglob::filter(names, pat);
+    unorderd_compare_results(
+        names, {"x" + ab + "y", "xx" + ab + "yy", "x" + ab + "cy"});
+  }
+}
+
 TEST_CASE("glob() function") {
   test_in_dir _;
 
@@ -191,6 +292,836 @@ TEST_CASE("recursive glob") {
   corrects = {"a", "a/b", "a/b/c", "d.txt", "a/e.txt", "a/f.txt", "a/b/g.txt"};
 
   unorderd_compare_results(vec, corrects);
+
+  // every way of globbing returns the paths in the order of the walk
+  const cppglob::pattern pat("**", true);
+  const std::vector<fs::path> walked(cppglob::iglob(pat), cppglob::iglob());
+  CHECK_EQ(cppglob::glob(pat), walked);
+  cppglob::path_list list;
+  CHECK_EQ(cppglob::glob(pat, list).to_vector(), walked);
+  cppglob::glob_options options;
+  options.threads = 4;
+  CHECK_EQ(cppglob::glob(pat, options), walked);
+  CHECK_EQ(cppglob::glob(std::vector<cppglob::pattern>{pat})[0], walked);
+}
+
+TEST_CASE("deep traversal") {
+  test_in_dir _;
+
+  fs::path deep;
+  for (int i = 0; i < 15; ++i) {
+    deep /= "d";
+  }
+  REQUIRE(fs::create_directories(deep / "x"));
+  create_file((deep / "x" / "f.txt").c_str());
+  create_file("g.txt");
+
+  std::vector<fs::path> vec = cppglob::glob("**/x/*.txt", true);
+  unorderd_compare_results(vec, {deep / "x" / "f.txt"});
+
+  vec = cppglob::glob("d/*/d/**/x/", true);
+  unorderd_compare_results(vec, {deep / "x" / ""});
+
+  vec = cppglob::glob("*/d/d");
+  unorderd_compare_results(vec, {"d/d/d"});
+
+  vec = cppglob::glob("g.txt/*");
+  unorderd_compare_results(vec, {});
+}
+
+TEST_CASE("segments after recursive glob") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a/c/b"));
+  REQUIRE(fs::create_directories("a/c/d"));
+  REQUIRE(fs::create_directories("a/.h/b"));
+  REQUIRE(fs::create_directories("a/b"));
+  REQUIRE(fs::create_directories("b"));
+  create_file("a/b/x.txt");
+  create_file("a/c/b/y.txt");
+  create_file("a/c/d/z.txt");
+  create_file("a/.h/b/w.txt");
+  create_file("b/v.txt");
+
+  std::vector<fs::path> vec = cppglob::glob("**/b/*.txt", true);
+  unorderd_compare_results(vec, {"a/b/x.txt", "a/c/b/y.txt", "b/v.txt"});
+
+  vec = cppglob::glob("a/**/b", true);
+  unorderd_compare_results(vec, {"a/b", "a/c/b"});
+
+  vec = cppglob::glob("a/**/b/", true);
+  unorderd_compare_results(vec, {"a/b/", "a/c/b/"});
+
+  vec = cppglob::glob("**/", true);
+  unorderd_compare_results(vec,
+                           {"a/", "a/b/", "a/c/", "a/c/b/", "a/c/d/", "b/"});
+
+  vec = cppglob::glob("a/**/../b", true);
+  unorderd_compare_results(vec, {"a/../b", "a/b/../b", "a/c/../b",
+                                 "a/c/b/../b", "a/c/d/../b"});
+}
+
+TEST_CASE("symbolic links to directories") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a/b"));
+  create_file("a/b/c.txt");
+  create_file("d.txt");
+  fs::create_directory_symlink("a", "l");
+  fs::create_symlink("d.txt", "f");
+
+  std::vector<fs::path> vec = cppglob::glob("*/");
+  unorderd_compare_results(vec, {"a/", "l/"});
+
+  vec = cppglob::glob("**/*.txt", true);
+  unorderd_compare_results(vec, {"d.txt", "a/b/c.txt", "l/b/c.txt"});
+}
+
+TEST_CASE("pattern class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a/b"));
+  create_file("a/c.txt");
+  create_file("a/b/d.txt");
+
+  const cppglob::pattern pat("a/**/*.txt", true);
+  CHECK_EQ(pat.path(), fs::path("a/**/*.txt"));
+  CHECK(pat.recursive());
+
+  for (int i = 0; i < 2; ++i) {
+    unorderd_compare_results(cppglob::glob(pat), {"a/c.txt", "a/b/d.txt"});
+  }
+
+  cppglob::glob_iterator it = cppglob::iglob(pat), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {"a/c.txt", "a/b/d.txt"});
+
+  const cppglob::pattern all("**", true);
+  unorderd_compare_results(cppglob::glob(all),
+                           {"a", "a/b", "a/c.txt", "a/b/d.txt"});
+  unorderd_compare_results(cppglob::glob(cppglob::pattern("a/*/")),
+                           {"a/b/"});
+  unorderd_compare_results(cppglob::glob(cppglob::pattern("a/c.txt")),
+                           {"a/c.txt"});
+  CHECK(cppglob::glob(cppglob::pattern()).empty());
+
+  const cppglob::pattern txt("*.txt");
+  CHECK(txt.match("c.txt"));
+  CHECK_FALSE(txt.match("c.txt.bak"));
+
+  std::vector<fs::path> names{"x.txt", "y.cpp", "z.txt"};
+  cppglob::filter(names, txt);
+  unorderd_compare_results(names, {"x.txt", "z.txt"});
+}
+
+TEST_CASE("parallel glob") {
+  test_in_dir _;
+
+  for (const char* dir : {"a", "b", "c"}) {
+    for (const char* sub : {"x", "y", "z"}) {
+      const fs::path path = fs::path(dir) / sub / "w";
+      REQUIRE(fs::create_directories(path));
+      create_file((path / "f.txt").c_str());
+      create_file((fs::path(dir) / sub / "g.txt").c_str());
+    }
+  }
+  create_file("h.txt");
+
+  cppglob::glob_options options;
+  options.threads = 4;
+
+  for (const char* pathname :
+       {"**", "**/*.txt", "*/y/**/", "a/**/w/*", "*/*/g.txt", "h.txt"}) {
+    const cppglob::pattern pat(pathname, true);
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+
+    options.ordered = true;
+    CHECK_EQ(cppglob::glob(pat, options), expected);
+
+    options.ordered = false;
+    unorderd_compare_results(cppglob::glob(pat, options), expected);
+  }
+
+  // every walker derives the extended groups on its own
+  for (const char* pathname : {"@(a|c)/**/!(g).txt", "*/+(x|y)/*.@(txt|h)"}) {
+    const cppglob::pattern pat(pathname, true, cppglob::pattern_flags::extglob);
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+    CHECK_FALSE(expected.empty());
+
+    options.ordered = true;
+    CHECK_EQ(cppglob::glob(pat, options), expected);
+  }
+
+  options.threads = 0;
+  CHECK_EQ(cppglob::glob(cppglob::pattern("*/*/"), options).size(), 9L);
+}
+
+TEST_CASE("path_list class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a/b"));
+  create_file("a/c.txt");
+  create_file("a/b/d.txt");
+
+  cppglob::path_list list;
+  CHECK(list.empty());
+  list.push_back("x");
+  list.push_back("");
+  list.push_back("y/z");
+  REQUIRE_EQ(list.size(), 3L);
+  CHECK_EQ(list[0], "x");
+  CHECK_EQ(list[1], "");
+  CHECK_EQ(list[2], "y/z");
+  CHECK_EQ(list.path(2), fs::path("y/z"));
+  CHECK_EQ(list.end() - list.begin(), 3L);
+  CHECK_EQ(list.begin()[2], "y/z");
+  CHECK_EQ(list.to_vector(), std::vector<fs::path>{"x", "", "y/z"});
+
+  list.clear();
+  CHECK(list.empty());
+
+  for (const char* pathname : {"**", "a/**/*.txt", "*/*/", "a/c.txt"}) {
+    const cppglob::pattern pat(pathname, true);
+    list.clear();
+    cppglob::glob(pat, list);
+    unorderd_compare_results(list.to_vector(), cppglob::glob(pat));
+  }
+
+  list.clear();
+  cppglob::glob(cppglob::pattern("a/*"), list);
+  cppglob::glob_iterator it(std::move(list)), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {"a/b", "a/c.txt"});
+}
+
+TEST_CASE("batch matching") {
+  cppglob::path_list names;
+  std::vector<fs::path> copies;
+  for (std::size_t i = 0; i < 300; ++i) {
+    const std::string name = "f" + std::to_string(i) +
+                             std::string(i % 40, 'x') +
+                             (i % 3 ? ".txt" : ".cpp");
+    names.push_back(name);
+    copies.push_back(name);
+  }
+  for (const char* name : {"", "x", "a/b.txt", "a/./b.txt"}) {
+    names.push_back(name);
+    copies.push_back(name);
+  }
+
+  std::vector<std::string> patterns{"*",      "*.txt",  "f1*",
+                                "*x.cpp", "f2*xxxx.txt", "*12*",
+                                "*1x*",   "f1.txt",   "f[0-9]*",
+                                "a/*.txt", "*.t?t"};
+  patterns.push_back("*" + std::string(34, 'x') + "*");
+
+  for (const std::string& pathname : patterns) {
+    const cppglob::pattern pat(pathname);
+    std::vector<std::uint64_t> bitmap;
+    std::size_t count = 0;
+    const std::size_t found = pat.match(names, bitmap);
+    REQUIRE_EQ(bitmap.size(), (names.size() + 63) / 64);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      const bool bit = ((bitmap[i / 64] >> (i % 64)) & 1) != 0;
+      CHECK_EQ(bit, pat.match(copies[i]));
+      count += bit ? 1 : 0;
+    }
+    CHECK_EQ(found, count);
+  }
+
+  // the SIMD kernels compare raw bytes, which must not be used for names
+  // folded by a case-insensitive pattern
+  cppglob::path_list accented;
+  for (const char* name : {"\u00c9", "\u00c9T\u00c9", "CAF\u00c9.txt", "e"}) {
+    accented.push_back(name);
+  }
+  const std::pair<const char*, std::uint64_t> icase_patterns[] = {
+      {"*\u00e9", 0x3}, {"\u00e9*", 0x3}, {"*\u00e9*", 0x7}};
+  for (const auto& [pathname, expected] : icase_patterns) {
+    const cppglob::pattern pat(pathname, false,
+                               cppglob::pattern_flags::case_insensitive);
+    std::vector<std::uint64_t> bitmap;
+    pat.match(accented, bitmap);
+    CHECK_EQ(bitmap[0], expected);
+  }
+}
+
+TEST_CASE("pattern_set class") {
+  const std::vector<fs::path> patterns = {
+      "*.txt",   "*.o",     "build",   "*cache*", "a*b*c",   "?",
+      "[ab]*",   "*.txt",   "x.txt",   "*xt",     "a/*.o",   "",
+      "*",       "abab*",   "*bab*",   "ab?ab*",  "*[.]o"};
+  const std::vector<fs::path> names = {
+      "",        "a",       "x.txt",   "y.o",     "build",   "builds",
+      "mycache", "aXbYc",   "ababab",  "babab",   "a/b.o",   "./x.txt",
+      "b",       "txt"};
+
+  const cppglob::pattern_set set(patterns);
+  REQUIRE_EQ(set.size(), patterns.size());
+  CHECK_EQ(set.path(3), patterns[3]);
+
+  for (const fs::path& name : names) {
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      if (cppglob::pattern(patterns[i]).match(name)) {
+        expected.push_back(i);
+      }
+    }
+    CHECK_MESSAGE(set.matches(name) == expected, "name: " << name);
+    CHECK_EQ(set.match_any(name), !expected.empty());
+  }
+
+  const cppglob::pattern_set empty;
+  CHECK(empty.matches("a").empty());
+  CHECK_FALSE(empty.match_any("a"));
+
+  std::vector<fs::path> files{"x.txt", "y.cpp", "z.o"};
+  cppglob::filter(files, cppglob::pattern_set({"*.txt", "*.o"}));
+  unorderd_compare_results(files, {"x.txt", "z.o"});
+}
+
+TEST_CASE("static patterns") {
+  static_assert(CPPGLOB_PATTERN("*.tar.gz").match("a.tar.gz"), "");
+  static_assert(!CPPGLOB_PATTERN("*.tar.gz").match("a.tar"), "");
+  static_assert(CPPGLOB_PATTERN("[a-f0-9][a-f0-9]*").match("3f1"), "");
+
+  const std::vector<std::string> names = {
+      "", "a", "ab", "abc", "a.txt", "x.y.z", "]x", "a-", "3f", "f0a", "aXbYc",
+      "a[", "c1", "./a.txt", "a/b.txt", "a/./b.txt"};
+  const auto check = [&names](auto pat) {
+    const fs::path pathname(pat.source());
+    const cppglob::pattern dynamic(pathname);
+    for (auto&& name : names) {
+      const fs::path path(name);
+      CHECK_MESSAGE(pat.match(name) == dynamic.match(path),
+                    "pattern: " << pathname << ", name: " << path);
+    }
+  };
+  check(CPPGLOB_PATTERN("*"));
+  check(CPPGLOB_PATTERN("a*"));
+  check(CPPGLOB_PATTERN("*a*"));
+  check(CPPGLOB_PATTERN("?"));
+  check(CPPGLOB_PATTERN("a*b*c"));
+  check(CPPGLOB_PATTERN("[ab]*"));
+  check(CPPGLOB_PATTERN("[!ab]*"));
+  check(CPPGLOB_PATTERN("[a-c]?"));
+  check(CPPGLOB_PATTERN("[]]*"));
+  check(CPPGLOB_PATTERN("*[0-9]"));
+  check(CPPGLOB_PATTERN("a["));
+  check(CPPGLOB_PATTERN("[a-f0-9][a-f0-9]*"));
+  check(CPPGLOB_PATTERN("a/*.txt"));
+
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a"));
+  create_file("b.txt");
+  create_file("c.cpp");
+  create_file("a/d.txt");
+
+  unorderd_compare_results(cppglob::glob(CPPGLOB_PATTERN("*.txt")),
+                           {"b.txt"});
+  unorderd_compare_results(
+      cppglob::glob(CPPGLOB_PATTERN("**/*.txt"), true),
+      {"b.txt", "a/d.txt"});
+
+  cppglob::glob_iterator it = cppglob::iglob(CPPGLOB_PATTERN("*/*.txt")),
+                         end;
+  unorderd_compare_results(std::vector<fs::path>(it, end), {"a/d.txt"});
+
+  std::vector<fs::path> files{"x.txt", "y.cpp", "./z.txt"};
+  cppglob::filter(files, CPPGLOB_PATTERN("*.txt"));
+  unorderd_compare_results(files, {"x.txt", "./z.txt"});
+}
+
+TEST_CASE("multiple patterns") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("include/x"));
+  REQUIRE(fs::create_directories("src/y"));
+  create_file("include/x/a.h");
+  create_file("src/b.cpp");
+  create_file("src/y/c.cpp");
+  create_file("src/CMakeLists.txt");
+  create_file("CMakeLists.txt");
+
+  const std::vector<cppglob::pattern> patterns = {
+      cppglob::pattern("include/**/*.h", true),
+      cppglob::pattern("src/**/*.cpp", true),
+      cppglob::pattern("**/CMakeLists.txt", true),
+      cppglob::pattern("src/**/*.cpp", true),
+      cppglob::pattern("**", true),
+      cppglob::pattern("src/*/"),
+      cppglob::pattern("src//*.cpp"),
+      cppglob::pattern("nonexistent/**", true),
+      cppglob::pattern("src/b.cpp")};
+
+  const std::vector<std::vector<fs::path>> results = cppglob::glob(patterns);
+  REQUIRE_EQ(results.size(), patterns.size());
+  for (std::size_t i = 0; i < patterns.size(); ++i) {
+    CHECK_EQ(results[i], cppglob::glob(patterns[i]));
+  }
+
+  unorderd_compare_results(results[2],
+                           {"CMakeLists.txt", "src/CMakeLists.txt"});
+  unorderd_compare_results(results[7], {"nonexistent/"});
+  CHECK(cppglob::glob(std::vector<cppglob::pattern>()).empty());
+}
+
+TEST_CASE("glob_context class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("src/a/b"));
+  REQUIRE(fs::create_directories("include"));
+  create_file("src/x.cpp");
+  create_file("src/a/y.cpp");
+  create_file("src/a/b/z.cpp");
+  create_file("include/w.h");
+
+  cppglob::glob_context context(2);
+  const fs::path pathnames[] = {"src/**/*.cpp", "*/*", "src/x.cpp",
+                                "**", "nonexistent/*"};
+  for (int round = 0; round < 3; ++round) {
+    for (const fs::path& pathname : pathnames) {
+      const cppglob::pattern pat(pathname, true);
+      unorderd_compare_results(context.glob(pathname, true).to_vector(),
+                               cppglob::glob(pat));
+      unorderd_compare_results(context.glob(pat).to_vector(),
+                               cppglob::glob(pat));
+    }
+  }
+
+  const cppglob::pattern braces("{src,include}/*.{cpp,h}", false,
+                                cppglob::pattern_flags::braces);
+  unorderd_compare_results(context.glob(braces).to_vector(),
+                           {"src/x.cpp", "include/w.h"});
+
+  // cached patterns are shared until they are replaced
+  const cppglob::pattern a = context.compile("src/*");
+  CHECK_EQ(&context.compile("src/*").path(), &a.path());
+  CHECK_NE(&context.compile("src/*", true).path(), &a.path());
+  context.compile("include/*");
+  CHECK_NE(&context.compile("src/*").path(), &a.path());
+  context.clear_cache();
+  CHECK_NE(&context.compile("include/*").path(), &a.path());
+
+  cppglob::path_list results;
+  context.glob(cppglob::pattern("src/*.cpp"), results);
+  context.glob(cppglob::pattern("include/*"), results);
+  CHECK_EQ(results.to_vector(),
+           std::vector<fs::path>{"src/x.cpp", "include/w.h"});
+
+  cppglob::glob_context moved(std::move(context));
+  CHECK_EQ(moved.glob("src/a/*.cpp").to_vector(),
+           std::vector<fs::path>{"src/a/y.cpp"});
+}
+
+TEST_CASE("memory resources") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("src/a/b"));
+  create_file("src/x.cpp");
+  create_file("src/a/y.cpp");
+  create_file("src/a/b/z.cpp");
+
+  // counts the allocations of the walk, and fails any other
+  struct counting_resource : std::pmr::memory_resource {
+    std::size_t count = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+      ++count;
+      return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t align) override {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  for (const cppglob::pattern& pat :
+       {cppglob::pattern("src/**/*.cpp", true), cppglob::pattern("*/*"),
+        cppglob::pattern("src/{x,a/y}.cpp", false,
+                         cppglob::pattern_flags::braces),
+        cppglob::pattern("src/x.cpp")}) {
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+
+    counting_resource counter;
+    std::pmr::memory_resource* old =
+        std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    cppglob::path_list results = cppglob::glob(pat, &counter);
+    std::pmr::set_default_resource(old);
+
+    CHECK_EQ(results.resource(), &counter);
+    CHECK_EQ(results.to_vector(), expected);
+    CHECK(counter.count > 0);
+
+    std::pmr::monotonic_buffer_resource arena;
+    cppglob::path_list list;
+    cppglob::glob(pat, list, &arena);
+    CHECK_EQ(list.resource(), std::pmr::get_default_resource());
+    CHECK_EQ(list.to_vector(), expected);
+  }
+}
+
+TEST_CASE("deep trees") {
+  test_in_dir _;
+
+  // every level holds a file, and the paths are built level by level
+  fs::path dir;
+  std::vector<fs::path> files;
+  for (int depth = 0; depth < 40; ++depth) {
+    dir /= "d" + std::to_string(depth);
+    REQUIRE(fs::create_directories(dir));
+    files.push_back(dir / "f.txt");
+    create_file(files.back().c_str());
+  }
+
+  unorderd_compare_results(cppglob::glob("**/f.txt", true), files);
+  std::vector<fs::path> iterated;
+  for (auto it = cppglob::iglob("d0/**/*.txt", true); it != cppglob::iglob();
+       ++it) {
+    iterated.push_back(*it);
+  }
+  unorderd_compare_results(iterated, files);
+
+  // directories matched by '**' are results and are entered at once
+  const std::vector<fs::path> all = cppglob::glob("**", true);
+  CHECK_EQ(all.size(), files.size() * 2);
+  for (const fs::path& path : all) {
+    CHECK(fs::exists(path));
+  }
+}
+
+TEST_CASE("listing cache") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("a/b"));
+  REQUIRE(fs::create_directories("c"));
+  for (const char* file :
+       {"w.txt", "a/x.txt", "a/b/y.txt", "c/z.txt", "c/v.md"}) {
+    create_file(file);
+  }
+
+  cppglob::glob_context context;
+  context.cache_listings(1000);
+  const cppglob::pattern pat("**/*.txt", true);
+  const auto check = [&context, &pat](std::vector<fs::path> expected) {
+    unorderd_compare_results(context.glob(pat).to_vector(), expected);
+    unorderd_compare_results(cppglob::glob(pat), expected);
+  };
+
+  // directories changed just now are read every time
+  check({"w.txt", "a/x.txt", "a/b/y.txt", "c/z.txt"});
+
+  // once they are old enough, their listings are stored and then reused
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  for (int i = 0; i < 3; ++i) {
+    check({"w.txt", "a/x.txt", "a/b/y.txt", "c/z.txt"});
+  }
+
+  // a changed directory is read again
+  create_file("a/b/n.txt");
+  fs::remove("c/z.txt");
+  fs::rename("a/x.txt", "a/m.txt");
+  REQUIRE(fs::create_directories("c/d"));
+  create_file("c/d/u.txt");
+  for (int i = 0; i < 2; ++i) {
+    check({"w.txt", "a/m.txt", "a/b/y.txt", "a/b/n.txt",
+           "c/d/u.txt"});
+  }
+
+  // a bound smaller than the tree keeps some of the listings
+  context.cache_listings(4);
+  for (int i = 0; i < 2; ++i) {
+    check({"w.txt", "a/m.txt", "a/b/y.txt", "a/b/n.txt",
+           "c/d/u.txt"});
+  }
+  context.cache_listings(0);
+  check({"w.txt", "a/m.txt", "a/b/y.txt", "a/b/n.txt",
+         "c/d/u.txt"});
+}
+
+#ifdef CPPGLOB_HAS_WATCHED_GLOB
+TEST_CASE("watched glob") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories("spool/a"));
+  for (const char* file : {"spool/x.job", "spool/a/y.job", "spool/a/z.txt"}) {
+    create_file(file);
+  }
+
+  using paths = std::vector<fs::path>;
+  const cppglob::pattern pat("spool/**/*.job", true);
+  const auto sorted_glob = [](const cppglob::pattern& p) {
+    paths files = cppglob::glob(p);
+    std::sort(files.begin(), files.end(),
+              [](const fs::path& x, const fs::path& y) {
+                return x.native() < y.native();
+              });
+    return files;
+  };
+
+  cppglob::watched_glob jobs(pat);
+  CHECK_EQ(jobs.snapshot(), sorted_glob(pat));
+  CHECK_FALSE(jobs.poll());
+  CHECK(jobs.added().empty());
+
+  // new files, and new directories with their contents
+  create_file("spool/a/n.job");
+  REQUIRE(fs::create_directories("spool/b/c"));
+  create_file("spool/b/c/m.job");
+  create_file("spool/b/c/m.txt");
+  CHECK(jobs.poll());
+  CHECK_EQ(jobs.added(), paths{"spool/a/n.job", "spool/b/c/m.job"});
+  CHECK(jobs.removed().empty());
+  CHECK_EQ(jobs.snapshot(), sorted_glob(pat));
+
+  // removed and renamed entries
+  fs::remove("spool/x.job");
+  fs::rename("spool/a", "spool/d");
+  CHECK(jobs.poll());
+  CHECK_EQ(jobs.added(), paths{"spool/d/n.job", "spool/d/y.job"});
+  CHECK_EQ(jobs.removed(),
+           paths{"spool/a/n.job", "spool/a/y.job", "spool/x.job"});
+  CHECK_EQ(jobs.snapshot(), sorted_glob(pat));
+
+  // a tree moved in from elsewhere is walked, a removed one is dropped
+  REQUIRE(fs::create_directories("outside/e"));
+  create_file("outside/e/o.job");
+  fs::rename("outside", "spool/f");
+  fs::remove_all("spool/b");
+  CHECK(jobs.poll());
+  CHECK_EQ(jobs.added(), paths{"spool/f/e/o.job"});
+  CHECK_EQ(jobs.removed(), paths{"spool/b/c/m.job"});
+  CHECK_EQ(jobs.snapshot(), sorted_glob(pat));
+
+  // a file which is removed again before poll() is not a change
+  create_file("spool/t.job");
+  fs::remove("spool/t.job");
+  CHECK_FALSE(jobs.poll(10));
+  CHECK_EQ(jobs.size(), 3);
+
+  // patterns without magic are found when they are created
+  cppglob::watched_glob late(cppglob::pattern("spool/late.job"));
+  CHECK_EQ(late.size(), 0);
+  create_file("spool/late.job");
+  CHECK(late.poll());
+  CHECK_EQ(late.snapshot(), paths{"spool/late.job"});
+
+  // brace patterns watch every group
+  const cppglob::pattern braces("spool/{d,f/e}/*.job", false,
+                                cppglob::pattern_flags::braces);
+  cppglob::watched_glob grouped(braces);
+  CHECK_EQ(grouped.snapshot(), sorted_glob(braces));
+  create_file("spool/f/e/q.job");
+  fs::remove("spool/d/y.job");
+  CHECK(grouped.poll());
+  CHECK_EQ(grouped.added(), paths{"spool/f/e/q.job"});
+  CHECK_EQ(grouped.removed(), paths{"spool/d/y.job"});
+  CHECK_EQ(grouped.snapshot(), sorted_glob(braces));
+
+  // a removed root is waited for and walked again when it is created
+  fs::remove_all("spool");
+  CHECK(jobs.poll());
+  CHECK_EQ(jobs.size(), 0);
+  CHECK(late.poll());
+  CHECK_EQ(late.size(), 0);
+  REQUIRE(fs::create_directories("spool/q"));
+  create_file("spool/q/a.job");
+  CHECK(jobs.poll());
+  CHECK_EQ(jobs.added(), paths{"spool/q/a.job"});
+  CHECK_EQ(jobs.snapshot(), sorted_glob(pat));
+  create_file("spool/late.job");
+  CHECK(late.poll());
+  CHECK_EQ(late.snapshot(), paths{"spool/late.job"});
+
+  // so is a root which does not exist yet, however deep it is
+  const cppglob::pattern deep("x/y/z/*.job");
+  cppglob::watched_glob pending(deep);
+  CHECK_EQ(pending.size(), 0);
+  REQUIRE(fs::create_directories("x/y"));
+  CHECK_FALSE(pending.poll());
+  REQUIRE(fs::create_directories("x/y/z"));
+  create_file("x/y/z/b.job");
+  CHECK(pending.poll());
+  CHECK_EQ(pending.snapshot(), paths{"x/y/z/b.job"});
+  fs::remove_all("x/y");
+  REQUIRE(fs::create_directories("x/y/z"));
+  create_file("x/y/z/c.job");
+  CHECK(pending.poll());
+  CHECK_EQ(pending.removed(), paths{"x/y/z/b.job"});
+  CHECK_EQ(pending.added(), paths{"x/y/z/c.job"});
+  CHECK_EQ(pending.snapshot(), sorted_glob(deep));
+}
+#endif
+
+TEST_CASE("brace expansion") {
+  test_in_dir _;
+
+  for (const char* dir : {"src/core", "src/net", "src/io", "src/other"}) {
+    REQUIRE(fs::create_directories(dir));
+  }
+  for (const char* file : {"src/core/a.cpp", "src/net/b.cpp", "src/io/c.cpp",
+                           "src/io/d.h", "src/other/e.cpp", "f1.txt",
+                           "f2.txt", "f3.txt", "x{y}", "{a,b}"}) {
+    create_file(file);
+  }
+
+  const auto braces = cppglob::pattern_flags::braces;
+  const auto glob = [&braces](const char* pathname, bool recursive = false) {
+    return cppglob::glob(cppglob::pattern(pathname, recursive, braces));
+  };
+
+  unorderd_compare_results(glob("src/{core,net,io}/**/*.cpp", true),
+                           {"src/core/a.cpp", "src/net/b.cpp", "src/io/c.cpp"});
+  CHECK(cppglob::glob(cppglob::pattern("src/{core,net,io}/**/*.cpp", true))
+            .empty());
+  unorderd_compare_results(
+      glob("src/{core,{net,io}}/*.{cpp,h}"),
+      {"src/core/a.cpp", "src/net/b.cpp", "src/io/c.cpp", "src/io/d.h"});
+  unorderd_compare_results(glob("{src/*,src/core}/a.cpp"), {"src/core/a.cpp"});
+  unorderd_compare_results(glob("{src/io,src}/{c.cpp,d.h,io/}"),
+                           {"src/io/c.cpp", "src/io/d.h", "src/io/"});
+  unorderd_compare_results(glob("{**/,src/io/}", true),
+                           {"src/", "src/core/", "src/net/", "src/io/",
+                            "src/other/"});
+  unorderd_compare_results(glob("f{1..5}.txt"), {"f1.txt", "f2.txt", "f3.txt"});
+  unorderd_compare_results(glob("f{3..1..2}.txt"), {"f1.txt", "f3.txt"});
+  unorderd_compare_results(glob("x{y}"), {"x{y}"});
+  unorderd_compare_results(glob("[{]a,b}"), {"{a,b}"});
+  unorderd_compare_results(glob("{/,src/}"), {"/", "src/"});
+  CHECK(glob("{,}").empty());
+
+  const cppglob::pattern pat("src/{core,net}/*.cpp", false, braces);
+  CHECK_EQ(pat.flags(), braces);
+  cppglob::glob_iterator it = cppglob::iglob(pat), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {"src/core/a.cpp", "src/net/b.cpp"});
+  CHECK_EQ(cppglob::glob(std::vector<cppglob::pattern>{pat})[0],
+           cppglob::glob(pat));
+
+  CHECK(pat.match("src/net/x.cpp"));
+  CHECK_FALSE(pat.match("src/io/x.cpp"));
+
+  const cppglob::pattern numbers("f{01..10}.{txt,c}", false, braces);
+  CHECK(numbers.match("f09.c"));
+  CHECK(numbers.match("f10.txt"));
+  CHECK_FALSE(numbers.match("f9.txt"));
+  CHECK(cppglob::pattern("{a..c}{-1..1}", false, braces).match("b-1"));
+  CHECK(cppglob::pattern("{a,{b{1,2},c}}", false, braces).match("b2"));
+  CHECK(cppglob::pattern("{a{b,c}", false, braces).match("{ac"));
+  CHECK(cppglob::pattern("{a..}", false, braces).match("{a..}"));
+
+  cppglob::path_list names;
+  for (const char* name : {"f1.txt", "f01.txt", "f10.c", "g.txt"}) {
+    names.push_back(name);
+  }
+  std::vector<std::uint64_t> bitmap;
+  CHECK_EQ(numbers.match(names, bitmap), 2L);
+  CHECK_EQ(bitmap[0], 0x6U);
+}
+
+TEST_CASE("extended globs") {
+  const auto extglob = cppglob::pattern_flags::extglob;
+  const auto match = [&extglob](const char* pathname, const std::string& name) {
+    return cppglob::pattern(pathname, false, extglob).match(name);
+  };
+
+  CHECK(match("@(a|b).txt", "a.txt"));
+  CHECK_FALSE(match("@(a|b).txt", "c.txt"));
+  CHECK(match("?(x)y", "y"));
+  CHECK(match("?(x)y", "xy"));
+  CHECK_FALSE(match("?(x)y", "xxy"));
+  CHECK(match("*(ab)", ""));
+  CHECK(match("*(ab)", "abab"));
+  CHECK_FALSE(match("*(ab)", "aba"));
+  CHECK(match("+(ab|c)d", "abccd"));
+  CHECK_FALSE(match("+(ab|c)d", "d"));
+  CHECK(match("!(*.txt)", "a.cpp"));
+  CHECK_FALSE(match("!(*.txt)", "a.txt"));
+  CHECK(match("*.!(txt|md)", "a.c"));
+  CHECK(match("*.!(txt|md)", "a.txt.bak"));
+  CHECK_FALSE(match("*.!(txt|md)", "a.md"));
+  CHECK(match("!(a)b", "b"));
+  CHECK_FALSE(match("!(a)b", "ab"));
+  CHECK(match("!(!(a))", "a"));
+  CHECK(match("@(a|+(b|c))x", "bcbx"));
+  CHECK(match("@([0-9]|[|])", "|"));
+  CHECK(match("a+b@x!y", "a+b@x!y"));
+  CHECK(match("*(a", "zz(a"));
+  CHECK(cppglob::pattern("@(a|b)").match("@(a|b)"));
+  CHECK_FALSE(cppglob::pattern("@(a|b)").match("a"));
+
+  // backtracking would take exponential time on these
+  const std::string as(5000, 'a');
+  CHECK_FALSE(match("+(a|aa)+(a|aa)!(a)b", as));
+  CHECK_FALSE(match("!(*a*a*)", as));
+  CHECK(match("*(a|aa)!(b)", as));
+
+  test_in_dir _;
+  REQUIRE(fs::create_directories("x"));
+  REQUIRE(fs::create_directories("y"));
+  for (const char* file :
+       {"a.txt", "b.txt", "c.md", "d.cpp", ".e.md", "x/f.txt", "y/g.md"}) {
+    create_file(file);
+  }
+
+  const auto glob = [&extglob](const char* pathname) {
+    return cppglob::glob(cppglob::pattern(pathname, false, extglob));
+  };
+  unorderd_compare_results(glob("!(*.txt)"),
+                           {".e.md", "c.md", "d.cpp", "x", "y"});
+  unorderd_compare_results(glob("@(a|c).*"), {"a.txt", "c.md"});
+  unorderd_compare_results(glob("@(x|y)/*"), {"x/f.txt", "y/g.md"});
+  unorderd_compare_results(
+      cppglob::glob(cppglob::pattern(
+          "{a,c,x/f}.@(txt|md)", false,
+          cppglob::pattern_flags::braces | extglob)),
+      {"a.txt", "c.md", "x/f.txt"});
+}
+
+TEST_CASE("case-insensitive matching") {
+  const auto icase = cppglob::pattern_flags::case_insensitive;
+  const auto match = [&icase](const char* pathname, const std::string& name) {
+    return cppglob::pattern(pathname, false, icase).match(name);
+  };
+
+  CHECK(match("*.TXT", "a.txt"));
+  CHECK(match("readme.md", "README.MD"));
+  CHECK(match("[a-c]x", "Bx"));
+  CHECK(match("[!a-c]x", "dX"));
+  CHECK_FALSE(match("[!a-c]x", "Bx"));
+  CHECK(match("a?c", "AbC"));
+  CHECK_FALSE(match("a?c", "abd"));
+  CHECK(match("\u00e9t\u00e9", "\u00c9T\u00c9"));
+  CHECK(match("k*", "\u212a"));
+  CHECK(match("stra\u00dfe", "STRA\u1e9eE"));
+  CHECK_FALSE(match("\u00e9", "e"));
+  CHECK(cppglob::pattern("@(A|b).txt", false,
+                         icase | cppglob::pattern_flags::extglob)
+            .match("a.TXT"));
+  CHECK_FALSE(cppglob::pattern("*.TXT").match("a.txt"));
+
+  test_in_dir _;
+  REQUIRE(fs::create_directories("Foo"));
+  REQUIRE(fs::create_directories("bar"));
+  for (const char* file : {"Foo/A.TXT", "Foo/b.txt", "Foo/c.md", "bar/D.Txt",
+                           "README.md", "\u00c9t\u00e9.txt"}) {
+    create_file(file);
+  }
+
+  const auto glob = [&icase](const char* pathname) {
+    return cppglob::glob(cppglob::pattern(pathname, false, icase));
+  };
+  unorderd_compare_results(glob("foo/*.txt"), {"Foo/A.TXT", "Foo/b.txt"});
+  unorderd_compare_results(glob("*/*.TXT"),
+                           {"Foo/A.TXT", "Foo/b.txt", "bar/D.Txt"});
+  unorderd_compare_results(glob("readme.MD"), {"README.md"});
+  unorderd_compare_results(glob("\u00e9T\u00c9.*"), {"\u00c9t\u00e9.txt"});
+  unorderd_compare_results(glob("FOO/"), {"Foo/"});
+  CHECK(cppglob::glob(cppglob::pattern("foo/*.txt")).empty());
 }
 
 TEST_CASE("escape() function") {
@@ -8,13 +8,18 @@
 
 #include <cstdio>
 #include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <regex>
 #include <string_view>
 #include <stdexcept>
+#include <thread>
 #include <filesystem>
 
 #include <cppglob/fnmatch.hpp>
 #include <cppglob/glob.hpp>
 #include <cppglob/iglob.hpp>
+#include <cppglob/static_pattern.hpp>
 #include "doctest.h"
 
 namespace fs = std::filesystem;
@@ -105,6 +110,41 @@ TEST_CASE("filter() function") {
   CHECK_EQ(names[1], fs::path(L".\\a\\..\\a\\b"));
 }
 
+TEST_CASE("filter() agrees with translate()") {
+  const std::vector<std::wstring> patterns = {
+      L"*",      L"*.txt",  L"a*",     L"*a*",    L"?",      L"??.c",
+      L"a*b*c",  L"*a*a*b", L"[ab]*",  L"[!ab]*", L"[a-c]?", L"[-a]*",
+      L"[a-]*",  L"*[0-9]", L"a[",     L"*.*.*",  L"abc",    L"x*y*z*",
+      L"[*]",    L"[?]a",   L"*[!.]",  L"a*c",    L"*b*",    L"a**c",
+      L"**a",    L"*.c*",   L"x*",     L"[a-f0-9][a-f0-9]*",
+      L"[!a-c]*", L"*ab*ab*", L"*a?b*[0-9]c*", L"x*[ab][ab]*z"};
+  const std::vector<std::wstring> names = {
+      L"",      L"a",     L"b",      L"ab",    L"abc",  L"aXbYc",
+      L"aab",   L"ba",    L"c1",     L"]x",    L"-",    L"a-",
+      L"x.txt", L"x.y.z", L"a[",     L"xyz",   L"xaybzc", L"*",
+      L"?a",    L"file9", L"aaaab",  L".",     L"ab.c",  L"3f",
+      L"0a1",   L"9g",    L"\u00e9", L"\u4e2d"};
+
+  for (auto&& pat : patterns) {
+    std::wregex re(cppglob::translate(pat));
+    for (auto&& name : names) {
+      std::vector<fs::path> vec = {name};
+      cppglob::filter(vec, pat);
+      CHECK_EQ(vec.size(), (std::regex_match(name, re) ? 1L : 0L));
+    }
+  }
+
+  // a leading ']' is a member of the set (ECMAScript regex reads "[]" as an
+  // empty class instead)
+  std::vector<fs::path> vec = {L"]x", L"a", L"x]"};
+  cppglob::filter(vec, L"[]]*");
+  unorderd_compare_results(vec, {L"]x"});
+
+  vec = {L"]x", L"a", L"x]"};
+  cppglob::filter(vec, L"[!]]*");
+  unorderd_compare_results(vec, {L"a", L"x]"});
+}
+
 TEST_CASE("iglob() function") {
   test_in_dir _;
 
@@ -127,6 +167,66 @@ TEST_CASE("iglob() function") {
                                  L"banana\\apple.txt"});
 }
 
+TEST_CASE("lazy iglob()") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a"));
+  create_file(L"a\\1.txt");
+  create_file(L"a\\2.txt");
+  create_file(L"a\\3.txt");
+
+  cppglob::glob_iterator it = cppglob::iglob(L"a\\*.txt"), end;
+  REQUIRE_NE(it, end);
+  const fs::path first = *it;
+
+  // copies share the same walk
+  cppglob::glob_iterator copied = it;
+  ++copied;
+  REQUIRE_NE(copied, end);
+  CHECK_NE(*copied, first);
+  CHECK_EQ(*it, first);
+
+  std::vector<fs::path> rest(copied, end);
+  CHECK_EQ(rest.size(), 2);
+  CHECK_EQ(++it, end);
+
+  CHECK_EQ(cppglob::iglob(L"b\\*\\*.txt"), end);
+}
+
+TEST_CASE("linear time matching") {
+  // every star would be retried at every position by a backtracking matcher
+  const std::wstring name(20000, L'a');
+  std::vector<fs::path> names{name, name + L"b"};
+  cppglob::filter(names, L"*a*a*a*a*a*a*b");
+  unorderd_compare_results(names, {name + L"b"});
+
+  names = {name, name + L"b", L"x" + name + L"ab"};
+  cppglob::filter(names, L"*aaaaaaaaaaab*");
+  unorderd_compare_results(names, {name + L"b", L"x" + name + L"ab"});
+
+  names = {name, name + L"ba", L"a" + name};
+  cppglob::filter(names, L"a*[ab]a[ab]a*?a");
+  unorderd_compare_results(names, {name, name + L"ba", L"a" + name});
+  // middle segments of 90 and 150 tokens
+  for (std::size_t len : {90, 150}) {
+    std::wstring pat = L"x*";
+    for (std::size_t i = 0; i < len; ++i) {
+      pat += L"[ab]";
+    }
+    pat += L"*y";
+
+    std::wstring ab;
+    for (std::size_t i = 0; i < len; ++i) {
+      ab += i % 3 ? L'a' : L'b';
+    }
+    names = {L"x" + ab + L"y", L"xx" + ab + L"yy", L"x" + ab.substr(1) + L"y",
+             L"x" + ab + L"cy"};
+    cppglob::filter(names, pat);
+    unorderd_compare_results(
+        names, {L"x" + ab + L"y", L"xx" + ab + L"yy", L"x" + ab + L"cy"});
+  }
+}
+
 TEST_CASE("glob() function") {
   test_in_dir _;
 
@@ -194,6 +294,725 @@ TEST_CASE("recursive glob") {
               L"a\\e.txt", L"a\\f.txt", L"a\\b\\g.txt"};
 
   unorderd_compare_results(vec, corrects);
+
+  // every way of globbing returns the paths in the order of the walk
+  const cppglob::pattern pat(L"**", true);
+  const std::vector<fs::path> walked(cppglob::iglob(pat), cppglob::iglob());
+  CHECK_EQ(cppglob::glob(pat), walked);
+  cppglob::path_list list;
+  CHECK_EQ(cppglob::glob(pat, list).to_vector(), walked);
+  cppglob::glob_options options;
+  options.threads = 4;
+  CHECK_EQ(cppglob::glob(pat, options), walked);
+  CHECK_EQ(cppglob::glob(std::vector<cppglob::pattern>{pat})[0], walked);
+}
+
+TEST_CASE("deep traversal") {
+  test_in_dir _;
+
+  fs::path deep;
+  for (int i = 0; i < 15; ++i) {
+    deep /= L"d";
+  }
+  REQUIRE(fs::create_directories(deep / L"x"));
+  create_file((deep / L"x" / L"f.txt").c_str());
+  create_file(L"g.txt");
+
+  std::vector<fs::path> vec = cppglob::glob(L"**\\x\\*.txt", true);
+  unorderd_compare_results(vec, {deep / L"x" / L"f.txt"});
+
+  vec = cppglob::glob(L"d\\*\\d\\**\\x\\", true);
+  unorderd_compare_results(vec, {deep / L"x" / L""});
+
+  vec = cppglob::glob(L"*\\d\\d");
+  unorderd_compare_results(vec, {L"d\\d\\d"});
+
+  vec = cppglob::glob(L"g.txt\\*");
+  unorderd_compare_results(vec, {});
+}
+
+TEST_CASE("segments after recursive glob") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a\\c\\b"));
+  REQUIRE(fs::create_directories(L"a\\c\\d"));
+  REQUIRE(fs::create_directories(L"a\\.h\\b"));
+  REQUIRE(fs::create_directories(L"a\\b"));
+  REQUIRE(fs::create_directories(L"b"));
+  create_file(L"a\\b\\x.txt");
+  create_file(L"a\\c\\b\\y.txt");
+  create_file(L"a\\c\\d\\z.txt");
+  create_file(L"a\\.h\\b\\w.txt");
+  create_file(L"b\\v.txt");
+
+  std::vector<fs::path> vec = cppglob::glob(L"**\\b\\*.txt", true);
+  unorderd_compare_results(vec,
+                           {L"a\\b\\x.txt", L"a\\c\\b\\y.txt", L"b\\v.txt"});
+
+  vec = cppglob::glob(L"a\\**\\b", true);
+  unorderd_compare_results(vec, {L"a\\b", L"a\\c\\b"});
+
+  vec = cppglob::glob(L"a\\**\\b\\", true);
+  unorderd_compare_results(vec, {L"a\\b\\", L"a\\c\\b\\"});
+
+  vec = cppglob::glob(L"**\\", true);
+  unorderd_compare_results(vec,
+                           {L"a\\", L"a\\b\\", L"a\\c\\", L"a\\c\\b\\",
+                            L"a\\c\\d\\", L"b\\"});
+
+  vec = cppglob::glob(L"a\\**\\..\\b", true);
+  unorderd_compare_results(vec, {L"a\\..\\b", L"a\\b\\..\\b",
+                                 L"a\\c\\..\\b", L"a\\c\\b\\..\\b",
+                                 L"a\\c\\d\\..\\b"});
+}
+
+TEST_CASE("pattern class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a\\b"));
+  create_file(L"a\\c.txt");
+  create_file(L"a\\b\\d.txt");
+
+  const cppglob::pattern pat(L"a\\**\\*.txt", true);
+  CHECK_EQ(pat.path(), fs::path(L"a\\**\\*.txt"));
+  CHECK(pat.recursive());
+
+  for (int i = 0; i < 2; ++i) {
+    unorderd_compare_results(cppglob::glob(pat), {L"a\\c.txt", L"a\\b\\d.txt"});
+  }
+
+  cppglob::glob_iterator it = cppglob::iglob(pat), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {L"a\\c.txt", L"a\\b\\d.txt"});
+
+  const cppglob::pattern all(L"**", true);
+  unorderd_compare_results(cppglob::glob(all),
+                           {L"a", L"a\\b", L"a\\c.txt", L"a\\b\\d.txt"});
+  unorderd_compare_results(cppglob::glob(cppglob::pattern(L"a\\*\\")),
+                           {L"a\\b\\"});
+  unorderd_compare_results(cppglob::glob(cppglob::pattern(L"a\\c.txt")),
+                           {L"a\\c.txt"});
+  CHECK(cppglob::glob(cppglob::pattern()).empty());
+
+  const cppglob::pattern txt(L"*.txt");
+  CHECK(txt.match(L"c.txt"));
+  CHECK_FALSE(txt.match(L"c.txt.bak"));
+
+  std::vector<fs::path> names{L"x.txt", L"y.cpp", L"z.txt"};
+  cppglob::filter(names, txt);
+  unorderd_compare_results(names, {L"x.txt", L"z.txt"});
+}
+
+TEST_CASE("parallel glob") {
+  test_in_dir _;
+
+  for (const wchar_t* dir : {L"a", L"b", L"c"}) {
+    for (const wchar_t* sub : {L"x", L"y", L"z"}) {
+      const fs::path path = fs::path(dir) / sub / L"w";
+      REQUIRE(fs::create_directories(path));
+      create_file((path / L"f.txt").c_str());
+      create_file((fs::path(dir) / sub / L"g.txt").c_str());
+    }
+  }
+  create_file(L"h.txt");
+
+  cppglob::glob_options options;
+  options.threads = 4;
+
+  for (const wchar_t* pathname : {L"**", L"**\\*.txt", L"*\\y\\**\\",
+                                  L"a\\**\\w\\*", L"*\\*\\g.txt", L"h.txt"}) {
+    const cppglob::pattern pat(pathname, true);
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+
+    options.ordered = true;
+    CHECK_EQ(cppglob::glob(pat, options), expected);
+
+    options.ordered = false;
+    unorderd_compare_results(cppglob::glob(pat, options), expected);
+  }
+
+  // every walker derives the extended groups on its own
+  for (const wchar_t* pathname :
+       {L"@(a|c)\\**\\!(g).txt", L"*\\+(x|y)\\*.@(txt|h)"}) {
+    const cppglob::pattern pat(pathname, true, cppglob::pattern_flags::extglob);
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+    CHECK_FALSE(expected.empty());
+
+    options.ordered = true;
+    CHECK_EQ(cppglob::glob(pat, options), expected);
+  }
+
+  options.threads = 0;
+  CHECK_EQ(cppglob::glob(cppglob::pattern(L"*\\*\\"), options).size(), 9L);
+}
+
+TEST_CASE("path_list class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a\\b"));
+  create_file(L"a\\c.txt");
+  create_file(L"a\\b\\d.txt");
+
+  cppglob::path_list list;
+  CHECK(list.empty());
+  list.push_back(L"x");
+  list.push_back(L"");
+  list.push_back(L"y\\z");
+  REQUIRE_EQ(list.size(), 3L);
+  CHECK(list[0] == L"x");
+  CHECK(list[1] == L"");
+  CHECK(list[2] == L"y\\z");
+  CHECK_EQ(list.path(2), fs::path(L"y\\z"));
+  CHECK_EQ(list.end() - list.begin(), 3L);
+  CHECK(list.begin()[2] == L"y\\z");
+  CHECK_EQ(list.to_vector(), std::vector<fs::path>{L"x", L"", L"y\\z"});
+
+  list.clear();
+  CHECK(list.empty());
+
+  for (const wchar_t* pathname :
+       {L"**", L"a\\**\\*.txt", L"*\\*\\", L"a\\c.txt"}) {
+    const cppglob::pattern pat(pathname, true);
+    list.clear();
+    cppglob::glob(pat, list);
+    unorderd_compare_results(list.to_vector(), cppglob::glob(pat));
+  }
+
+  list.clear();
+  cppglob::glob(cppglob::pattern(L"a\\*"), list);
+  cppglob::glob_iterator it(std::move(list)), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {L"a\\b", L"a\\c.txt"});
+}
+
+TEST_CASE("batch matching") {
+  cppglob::path_list names;
+  std::vector<fs::path> copies;
+  for (std::size_t i = 0; i < 300; ++i) {
+    const std::wstring name = L"f" + std::to_wstring(i) +
+                              std::wstring(i % 40, L'x') +
+                              (i % 3 ? L".txt" : L".cpp");
+    names.push_back(name);
+    copies.push_back(name);
+  }
+  for (const wchar_t* name : {L"", L"x", L"a\\b.txt", L"a\\.\\b.txt"}) {
+    names.push_back(name);
+    copies.push_back(name);
+  }
+
+  std::vector<std::wstring> patterns{L"*",      L"*.txt",  L"f1*",
+                                L"*x.cpp", L"f2*xxxx.txt", L"*12*",
+                                L"*1x*",   L"f1.txt",   L"f[0-9]*",
+                                L"a\\*.txt", L"*.t?t"};
+  patterns.push_back(L"*" + std::wstring(34, L'x') + L"*");
+
+  for (const std::wstring& pathname : patterns) {
+    const cppglob::pattern pat(pathname);
+    std::vector<std::uint64_t> bitmap;
+    std::size_t count = 0;
+    const std::size_t found = pat.match(names, bitmap);
+    REQUIRE_EQ(bitmap.size(), (names.size() + 63) / 64);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      const bool bit = ((bitmap[i / 64] >> (i % 64)) & 1) != 0;
+      CHECK_EQ(bit, pat.match(copies[i]));
+      count += bit ? 1 : 0;
+    }
+    CHECK_EQ(found, count);
+  }
+
+  // the SIMD kernels compare raw bytes, which must not be used for names
+  // folded by a case-insensitive pattern
+  cppglob::path_list accented;
+  for (const wchar_t* name :
+       {L"\u00c9", L"\u00c9T\u00c9", L"CAF\u00c9.txt", L"e"}) {
+    accented.push_back(name);
+  }
+  const std::pair<const wchar_t*, std::uint64_t> icase_patterns[] = {
+      {L"*\u00e9", 0x3}, {L"\u00e9*", 0x3}, {L"*\u00e9*", 0x7}};
+  for (const auto& [pathname, expected] : icase_patterns) {
+    const cppglob::pattern pat(pathname, false,
+                               cppglob::pattern_flags::case_insensitive);
+    std::vector<std::uint64_t> bitmap;
+    pat.match(accented, bitmap);
+    CHECK_EQ(bitmap[0], expected);
+  }
+}
+
+TEST_CASE("pattern_set class") {
+  const std::vector<fs::path> patterns = {
+      L"*.txt",   L"*.o",     L"build",   L"*cache*", L"a*b*c",   L"?",
+      L"[ab]*",   L"*.txt",   L"x.txt",   L"*xt",     L"a\\*.o",  L"",
+      L"*",       L"abab*",   L"*bab*",   L"ab?ab*",  L"*[.]o"};
+  const std::vector<fs::path> names = {
+      L"",         L"a",        L"x.txt",    L"y.o",      L"build",
+      L"builds",   L"mycache",  L"aXbYc",    L"ababab",   L"babab",
+      L"a\\b.o",   L".\\x.txt", L"b",        L"txt"};
+
+  const cppglob::pattern_set set(patterns);
+  REQUIRE_EQ(set.size(), patterns.size());
+  CHECK_EQ(set.path(3), patterns[3]);
+
+  for (const fs::path& name : names) {
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 0; i < patterns.size(); ++i) {
+      if (cppglob::pattern(patterns[i]).match(name)) {
+        expected.push_back(i);
+      }
+    }
+    CHECK_MESSAGE(set.matches(name) == expected, "name: " << name);
+    CHECK_EQ(set.match_any(name), !expected.empty());
+  }
+
+  const cppglob::pattern_set empty;
+  CHECK(empty.matches(L"a").empty());
+  CHECK_FALSE(empty.match_any(L"a"));
+
+  std::vector<fs::path> files{L"x.txt", L"y.cpp", L"z.o"};
+  cppglob::filter(files, cppglob::pattern_set({L"*.txt", L"*.o"}));
+  unorderd_compare_results(files, {L"x.txt", L"z.o"});
+}
+
+TEST_CASE("static patterns") {
+  static_assert(CPPGLOB_PATTERN(L"*.tar.gz").match(L"a.tar.gz"), "");
+  static_assert(!CPPGLOB_PATTERN(L"*.tar.gz").match(L"a.tar"), "");
+  static_assert(CPPGLOB_PATTERN(L"[a-f0-9][a-f0-9]*").match(L"3f1"), "");
+
+  const std::vector<std::wstring> names = {
+      L"", L"a", L"ab", L"abc", L"a.txt", L"x.y.z", L"]x", L"a-", L"3f", L"f0a",
+      L"aXbYc", L"a[", L"c1", L".\\a.txt", L"a\\b.txt", L"a\\.\\b.txt"};
+  const auto check = [&names](auto pat) {
+    const fs::path pathname(pat.source());
+    const cppglob::pattern dynamic(pathname);
+    for (auto&& name : names) {
+      const fs::path path(name);
+      CHECK_MESSAGE(pat.match(name) == dynamic.match(path),
+                    "pattern: " << pathname << ", name: " << path);
+    }
+  };
+  check(CPPGLOB_PATTERN(L"*"));
+  check(CPPGLOB_PATTERN(L"a*"));
+  check(CPPGLOB_PATTERN(L"*a*"));
+  check(CPPGLOB_PATTERN(L"?"));
+  check(CPPGLOB_PATTERN(L"a*b*c"));
+  check(CPPGLOB_PATTERN(L"[ab]*"));
+  check(CPPGLOB_PATTERN(L"[!ab]*"));
+  check(CPPGLOB_PATTERN(L"[a-c]?"));
+  check(CPPGLOB_PATTERN(L"[]]*"));
+  check(CPPGLOB_PATTERN(L"*[0-9]"));
+  check(CPPGLOB_PATTERN(L"a["));
+  check(CPPGLOB_PATTERN(L"[a-f0-9][a-f0-9]*"));
+  check(CPPGLOB_PATTERN(L"a\\*.txt"));
+
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a"));
+  create_file(L"b.txt");
+  create_file(L"c.cpp");
+  create_file(L"a\\d.txt");
+
+  unorderd_compare_results(cppglob::glob(CPPGLOB_PATTERN(L"*.txt")),
+                           {L"b.txt"});
+  unorderd_compare_results(
+      cppglob::glob(CPPGLOB_PATTERN(L"**\\*.txt"), true),
+      {L"b.txt", L"a\\d.txt"});
+
+  cppglob::glob_iterator it = cppglob::iglob(CPPGLOB_PATTERN(L"*\\*.txt")),
+                         end;
+  unorderd_compare_results(std::vector<fs::path>(it, end), {L"a\\d.txt"});
+
+  std::vector<fs::path> files{L"x.txt", L"y.cpp", L".\\z.txt"};
+  cppglob::filter(files, CPPGLOB_PATTERN(L"*.txt"));
+  unorderd_compare_results(files, {L"x.txt", L".\\z.txt"});
+}
+
+TEST_CASE("multiple patterns") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"include\\x"));
+  REQUIRE(fs::create_directories(L"src\\y"));
+  create_file(L"include\\x\\a.h");
+  create_file(L"src\\b.cpp");
+  create_file(L"src\\y\\c.cpp");
+  create_file(L"src\\CMakeLists.txt");
+  create_file(L"CMakeLists.txt");
+
+  const std::vector<cppglob::pattern> patterns = {
+      cppglob::pattern(L"include\\**\\*.h", true),
+      cppglob::pattern(L"src\\**\\*.cpp", true),
+      cppglob::pattern(L"**\\CMakeLists.txt", true),
+      cppglob::pattern(L"src\\**\\*.cpp", true),
+      cppglob::pattern(L"**", true),
+      cppglob::pattern(L"src\\*\\"),
+      cppglob::pattern(L"src\\\\*.cpp"),
+      cppglob::pattern(L"nonexistent\\**", true),
+      cppglob::pattern(L"src\\b.cpp")};
+
+  const std::vector<std::vector<fs::path>> results = cppglob::glob(patterns);
+  REQUIRE_EQ(results.size(), patterns.size());
+  for (std::size_t i = 0; i < patterns.size(); ++i) {
+    CHECK_EQ(results[i], cppglob::glob(patterns[i]));
+  }
+
+  unorderd_compare_results(results[2],
+                           {L"CMakeLists.txt", L"src\\CMakeLists.txt"});
+  unorderd_compare_results(results[7], {L"nonexistent\\"});
+  CHECK(cppglob::glob(std::vector<cppglob::pattern>()).empty());
+}
+
+TEST_CASE("glob_context class") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"src\\a\\b"));
+  REQUIRE(fs::create_directories(L"include"));
+  create_file(L"src\\x.cpp");
+  create_file(L"src\\a\\y.cpp");
+  create_file(L"src\\a\\b\\z.cpp");
+  create_file(L"include\\w.h");
+
+  cppglob::glob_context context(2);
+  const fs::path pathnames[] = {L"src\\**\\*.cpp", L"*\\*",
+                                L"src\\x.cpp", L"**", L"nonexistent\\*"};
+  for (int round = 0; round < 3; ++round) {
+    for (const fs::path& pathname : pathnames) {
+      const cppglob::pattern pat(pathname, true);
+      unorderd_compare_results(context.glob(pathname, true).to_vector(),
+                               cppglob::glob(pat));
+      unorderd_compare_results(context.glob(pat).to_vector(),
+                               cppglob::glob(pat));
+    }
+  }
+
+  const cppglob::pattern braces(L"{src,include}\\*.{cpp,h}", false,
+                                cppglob::pattern_flags::braces);
+  unorderd_compare_results(context.glob(braces).to_vector(),
+                           {L"src\\x.cpp", L"include\\w.h"});
+
+  // cached patterns are shared until they are replaced
+  const cppglob::pattern a = context.compile(L"src\\*");
+  CHECK_EQ(&context.compile(L"src\\*").path(), &a.path());
+  CHECK_NE(&context.compile(L"src\\*", true).path(), &a.path());
+  context.compile(L"include\\*");
+  CHECK_NE(&context.compile(L"src\\*").path(), &a.path());
+  context.clear_cache();
+  CHECK_NE(&context.compile(L"include\\*").path(), &a.path());
+
+  cppglob::path_list results;
+  context.glob(cppglob::pattern(L"src\\*.cpp"), results);
+  context.glob(cppglob::pattern(L"include\\*"), results);
+  CHECK_EQ(results.to_vector(),
+           std::vector<fs::path>{L"src\\x.cpp", L"include\\w.h"});
+
+  cppglob::glob_context moved(std::move(context));
+  CHECK_EQ(moved.glob(L"src\\a\\*.cpp").to_vector(),
+           std::vector<fs::path>{L"src\\a\\y.cpp"});
+}
+
+TEST_CASE("memory resources") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"src\\a\\b"));
+  create_file(L"src\\x.cpp");
+  create_file(L"src\\a\\y.cpp");
+  create_file(L"src\\a\\b\\z.cpp");
+
+  // counts the allocations of the walk, and fails any other
+  struct counting_resource : std::pmr::memory_resource {
+    std::size_t count = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+      ++count;
+      return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, std::size_t bytes,
+                       std::size_t align) override {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  for (const cppglob::pattern& pat :
+       {cppglob::pattern(L"src\\**\\*.cpp", true), cppglob::pattern(L"*\\*"),
+        cppglob::pattern(L"src\\{x,a\\y}.cpp", false,
+                         cppglob::pattern_flags::braces),
+        cppglob::pattern(L"src\\x.cpp")}) {
+    const std::vector<fs::path> expected = cppglob::glob(pat);
+
+    counting_resource counter;
+    std::pmr::memory_resource* old =
+        std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    cppglob::path_list results = cppglob::glob(pat, &counter);
+    std::pmr::set_default_resource(old);
+
+    CHECK_EQ(results.resource(), &counter);
+    CHECK_EQ(results.to_vector(), expected);
+    CHECK(counter.count > 0);
+
+    std::pmr::monotonic_buffer_resource arena;
+    cppglob::path_list list;
+    cppglob::glob(pat, list, &arena);
+    CHECK_EQ(list.resource(), std::pmr::get_default_resource());
+    CHECK_EQ(list.to_vector(), expected);
+  }
+}
+
+TEST_CASE("deep trees") {
+  test_in_dir _;
+
+  // every level holds a file, and the paths are built level by level
+  fs::path dir;
+  std::vector<fs::path> files;
+  for (int depth = 0; depth < 40; ++depth) {
+    dir /= L"d" + std::to_wstring(depth);
+    REQUIRE(fs::create_directories(dir));
+    files.push_back(dir / L"f.txt");
+    create_file(files.back().c_str());
+  }
+
+  unorderd_compare_results(cppglob::glob(L"**\\f.txt", true), files);
+  std::vector<fs::path> iterated;
+  for (auto it = cppglob::iglob(L"d0\\**\\*.txt", true); it != cppglob::iglob();
+       ++it) {
+    iterated.push_back(*it);
+  }
+  unorderd_compare_results(iterated, files);
+
+  // directories matched by '**' are results and are entered at once
+  const std::vector<fs::path> all = cppglob::glob(L"**", true);
+  CHECK_EQ(all.size(), files.size() * 2);
+  for (const fs::path& path : all) {
+    CHECK(fs::exists(path));
+  }
+}
+
+TEST_CASE("listing cache") {
+  test_in_dir _;
+
+  REQUIRE(fs::create_directories(L"a\\b"));
+  REQUIRE(fs::create_directories(L"c"));
+  for (const wchar_t* file :
+       {L"w.txt", L"a\\x.txt", L"a\\b\\y.txt", L"c\\z.txt", L"c\\v.md"}) {
+    create_file(file);
+  }
+
+  cppglob::glob_context context;
+  context.cache_listings(1000);
+  const cppglob::pattern pat(L"**\\*.txt", true);
+  const auto check = [&context, &pat](std::vector<fs::path> expected) {
+    unorderd_compare_results(context.glob(pat).to_vector(), expected);
+    unorderd_compare_results(cppglob::glob(pat), expected);
+  };
+
+  // directories changed just now are read every time
+  check({L"w.txt", L"a\\x.txt", L"a\\b\\y.txt", L"c\\z.txt"});
+
+  // once they are old enough, their listings are stored and then reused
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  for (int i = 0; i < 3; ++i) {
+    check({L"w.txt", L"a\\x.txt", L"a\\b\\y.txt", L"c\\z.txt"});
+  }
+
+  // a changed directory is read again
+  create_file(L"a\\b\\n.txt");
+  fs::remove(L"c\\z.txt");
+  fs::rename(L"a\\x.txt", L"a\\m.txt");
+  REQUIRE(fs::create_directories(L"c\\d"));
+  create_file(L"c\\d\\u.txt");
+  for (int i = 0; i < 2; ++i) {
+    check({L"w.txt", L"a\\m.txt", L"a\\b\\y.txt", L"a\\b\\n.txt",
+           L"c\\d\\u.txt"});
+  }
+
+  // a bound smaller than the tree keeps some of the listings
+  context.cache_listings(4);
+  for (int i = 0; i < 2; ++i) {
+    check({L"w.txt", L"a\\m.txt", L"a\\b\\y.txt", L"a\\b\\n.txt",
+           L"c\\d\\u.txt"});
+  }
+  context.cache_listings(0);
+  check({L"w.txt", L"a\\m.txt", L"a\\b\\y.txt", L"a\\b\\n.txt",
+         L"c\\d\\u.txt"});
+}
+
+TEST_CASE("brace expansion") {
+  test_in_dir _;
+
+  for (const wchar_t* dir :
+       {L"src\\core", L"src\\net", L"src\\io", L"src\\other"}) {
+    REQUIRE(fs::create_directories(dir));
+  }
+  for (const wchar_t* file :
+       {L"src\\core\\a.cpp", L"src\\net\\b.cpp", L"src\\io\\c.cpp",
+        L"src\\io\\d.h", L"src\\other\\e.cpp", L"f1.txt", L"f2.txt",
+        L"f3.txt", L"x{y}", L"{a,b}"}) {
+    create_file(file);
+  }
+
+  const auto braces = cppglob::pattern_flags::braces;
+  const auto glob = [&braces](const wchar_t* pathname,
+                              bool recursive = false) {
+    return cppglob::glob(cppglob::pattern(pathname, recursive, braces));
+  };
+
+  unorderd_compare_results(
+      glob(L"src\\{core,net,io}\\**\\*.cpp", true),
+      {L"src\\core\\a.cpp", L"src\\net\\b.cpp", L"src\\io\\c.cpp"});
+  CHECK(cppglob::glob(cppglob::pattern(L"src\\{core,net,io}\\**\\*.cpp",
+                                       true))
+            .empty());
+  unorderd_compare_results(
+      glob(L"src\\{core,{net,io}}\\*.{cpp,h}"),
+      {L"src\\core\\a.cpp", L"src\\net\\b.cpp", L"src\\io\\c.cpp",
+       L"src\\io\\d.h"});
+  unorderd_compare_results(glob(L"{src\\*,src\\core}\\a.cpp"),
+                           {L"src\\core\\a.cpp"});
+  unorderd_compare_results(
+      glob(L"{src\\io,src}\\{c.cpp,d.h,io\\}"),
+      {L"src\\io\\c.cpp", L"src\\io\\d.h", L"src\\io\\"});
+  unorderd_compare_results(glob(L"{**\\,src\\io\\}", true),
+                           {L"src\\", L"src\\core\\", L"src\\net\\",
+                            L"src\\io\\", L"src\\other\\"});
+  unorderd_compare_results(glob(L"f{1..5}.txt"),
+                           {L"f1.txt", L"f2.txt", L"f3.txt"});
+  unorderd_compare_results(glob(L"f{3..1..2}.txt"), {L"f1.txt", L"f3.txt"});
+  unorderd_compare_results(glob(L"x{y}"), {L"x{y}"});
+  unorderd_compare_results(glob(L"[{]a,b}"), {L"{a,b}"});
+  CHECK(glob(L"{,}").empty());
+
+  const cppglob::pattern pat(L"src\\{core,net}\\*.cpp", false, braces);
+  CHECK_EQ(pat.flags(), braces);
+  cppglob::glob_iterator it = cppglob::iglob(pat), end;
+  unorderd_compare_results(std::vector<fs::path>(it, end),
+                           {L"src\\core\\a.cpp", L"src\\net\\b.cpp"});
+  CHECK_EQ(cppglob::glob(std::vector<cppglob::pattern>{pat})[0],
+           cppglob::glob(pat));
+
+  CHECK(pat.match(L"src\\net\\x.cpp"));
+  CHECK_FALSE(pat.match(L"src\\io\\x.cpp"));
+
+  const cppglob::pattern numbers(L"f{01..10}.{txt,c}", false, braces);
+  CHECK(numbers.match(L"f09.c"));
+  CHECK(numbers.match(L"f10.txt"));
+  CHECK_FALSE(numbers.match(L"f9.txt"));
+  CHECK(cppglob::pattern(L"{a..c}{-1..1}", false, braces).match(L"b-1"));
+  CHECK(cppglob::pattern(L"{a,{b{1,2},c}}", false, braces).match(L"b2"));
+  CHECK(cppglob::pattern(L"{a{b,c}", false, braces).match(L"{ac"));
+  CHECK(cppglob::pattern(L"{a..}", false, braces).match(L"{a..}"));
+
+  cppglob::path_list names;
+  for (const wchar_t* name : {L"f1.txt", L"f01.txt", L"f10.c", L"g.txt"}) {
+    names.push_back(name);
+  }
+  std::vector<std::uint64_t> bitmap;
+  CHECK_EQ(numbers.match(names, bitmap), 2L);
+  CHECK_EQ(bitmap[0], 0x6U);
+}
+
+TEST_CASE("extended globs") {
+  const auto extglob = cppglob::pattern_flags::extglob;
+  const auto match = [&extglob](const wchar_t* pathname,
+                                const std::wstring& name) {
+    return cppglob::pattern(pathname, false, extglob).match(name);
+  };
+
+  CHECK(match(L"@(a|b).txt", L"a.txt"));
+  CHECK_FALSE(match(L"@(a|b).txt", L"c.txt"));
+  CHECK(match(L"?(x)y", L"y"));
+  CHECK(match(L"?(x)y", L"xy"));
+  CHECK_FALSE(match(L"?(x)y", L"xxy"));
+  CHECK(match(L"*(ab)", L""));
+  CHECK(match(L"*(ab)", L"abab"));
+  CHECK_FALSE(match(L"*(ab)", L"aba"));
+  CHECK(match(L"+(ab|c)d", L"abccd"));
+  CHECK_FALSE(match(L"+(ab|c)d", L"d"));
+  CHECK(match(L"!(*.txt)", L"a.cpp"));
+  CHECK_FALSE(match(L"!(*.txt)", L"a.txt"));
+  CHECK(match(L"*.!(txt|md)", L"a.c"));
+  CHECK(match(L"*.!(txt|md)", L"a.txt.bak"));
+  CHECK_FALSE(match(L"*.!(txt|md)", L"a.md"));
+  CHECK(match(L"!(a)b", L"b"));
+  CHECK_FALSE(match(L"!(a)b", L"ab"));
+  CHECK(match(L"!(!(a))", L"a"));
+  CHECK(match(L"@(a|+(b|c))x", L"bcbx"));
+  CHECK(match(L"@([0-9]|[|])", L"|"));
+  CHECK(match(L"a+b@x!y", L"a+b@x!y"));
+  CHECK(match(L"*(a", L"zz(a"));
+  CHECK(match(L"@(\u00e9|\u4e2d)", L"\u4e2d"));
+  CHECK(cppglob::pattern(L"@(a|b)").match(L"@(a|b)"));
+  CHECK_FALSE(cppglob::pattern(L"@(a|b)").match(L"a"));
+
+  // backtracking would take exponential time on these
+  const std::wstring as(5000, L'a');
+  CHECK_FALSE(match(L"+(a|aa)+(a|aa)!(a)b", as));
+  CHECK_FALSE(match(L"!(*a*a*)", as));
+  CHECK(match(L"*(a|aa)!(b)", as));
+
+  test_in_dir _;
+  REQUIRE(fs::create_directories(L"x"));
+  REQUIRE(fs::create_directories(L"y"));
+  for (const wchar_t* file : {L"a.txt", L"b.txt", L"c.md", L"d.cpp", L".e.md",
+                              L"x\\f.txt", L"y\\g.md"}) {
+    create_file(file);
+  }
+
+  const auto glob = [&extglob](const wchar_t* pathname) {
+    return cppglob::glob(cppglob::pattern(pathname, false, extglob));
+  };
+  unorderd_compare_results(glob(L"!(*.txt)"),
+                           {L".e.md", L"c.md", L"d.cpp", L"x", L"y"});
+  unorderd_compare_results(glob(L"@(a|c).*"), {L"a.txt", L"c.md"});
+  unorderd_compare_results(glob(L"@(x|y)\\*"),
+                           {L"x\\f.txt", L"y\\g.md"});
+  unorderd_compare_results(
+      cppglob::glob(cppglob::pattern(
+          L"{a,c,x\\f}.@(txt|md)", false,
+          cppglob::pattern_flags::braces | extglob)),
+      {L"a.txt", L"c.md", L"x\\f.txt"});
+}
+
+TEST_CASE("case-insensitive matching") {
+  const auto icase = cppglob::pattern_flags::case_insensitive;
+  const auto match = [&icase](const wchar_t* pathname,
+                              const std::wstring& name) {
+    return cppglob::pattern(pathname, false, icase).match(name);
+  };
+
+  CHECK(match(L"*.TXT", L"a.txt"));
+  CHECK(match(L"readme.md", L"README.MD"));
+  CHECK(match(L"[a-c]x", L"Bx"));
+  CHECK(match(L"[!a-c]x", L"dX"));
+  CHECK_FALSE(match(L"[!a-c]x", L"Bx"));
+  CHECK(match(L"a?c", L"AbC"));
+  CHECK_FALSE(match(L"a?c", L"abd"));
+  CHECK(match(L"\u00e9t\u00e9", L"\u00c9T\u00c9"));
+  CHECK(match(L"k*", L"\u212a"));
+  CHECK(match(L"stra\u00dfe", L"STRA\u1e9eE"));
+  CHECK_FALSE(match(L"\u00e9", L"e"));
+  CHECK(cppglob::pattern(L"@(A|b).txt", false,
+                         icase | cppglob::pattern_flags::extglob)
+            .match(L"a.TXT"));
+  CHECK_FALSE(cppglob::pattern(L"*.TXT").match(L"a.txt"));
+
+  test_in_dir _;
+  REQUIRE(fs::create_directories(L"Foo"));
+  REQUIRE(fs::create_directories(L"bar"));
+  for (const wchar_t* file : {L"Foo\\A.TXT", L"Foo\\b.txt", L"Foo\\c.md",
+                              L"bar\\D.Txt", L"README.md",
+                              L"\u00c9t\u00e9.txt"}) {
+    create_file(file);
+  }
+
+  const auto glob = [&icase](const wchar_t* pathname) {
+    return cppglob::glob(cppglob::pattern(pathname, false, icase));
+  };
+  unorderd_compare_results(glob(L"Foo\\*.txt"),
+                           {L"Foo\\A.TXT", L"Foo\\b.txt"});
+  unorderd_compare_results(glob(L"*\\*.TXT"),
+                           {L"Foo\\A.TXT", L"Foo\\b.txt", L"bar\\D.Txt"});
+  unorderd_compare_results(glob(L"*.MD"), {L"README.md"});
+  unorderd_compare_results(glob(L"\u00e9T\u00c9.*"),
+                           {L"\u00c9t\u00e9.txt"});
 }
 
 TEST_CASE("escape() function") {